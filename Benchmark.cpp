@@ -0,0 +1,230 @@
+#include "Benchmark.h"
+#include <chrono>
+#include <iomanip>
+#include <random>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * @file Benchmark.cpp
+ * @brief Implementation of the engine benchmarks.
+ */
+
+/**
+ * @brief Constructs a benchmark.
+ * @param points The points to cluster.
+ * @param k The number of clusters.
+ * @param runs The number of timed fits per configuration.
+ * @throws invalid_argument If runs or k is not positive, or there are fewer than k points.
+ */
+Benchmark::Benchmark(const PointSpan& points, int k, int runs)
+    : points(points), K(k), runs(runs) {
+    if (runs <= 0) {
+        throw invalid_argument("Benchmark runs must be a positive number.");
+    }
+    if (k <= 0) {
+        throw invalid_argument("K must be a positive number.");
+    }
+    if (points.size() < static_cast<size_t>(k)) {
+        throw invalid_argument("K must not exceed the number of samples.");
+    }
+}
+
+/**
+ * @brief Times one engine configuration.
+ * @param label Name printed for the configuration.
+ * @param options The engine options.
+ * @return The timing and the outcome of the last fit.
+ */
+BenchmarkTiming Benchmark::measure(const string& label, const KMeansOptions& options) {
+    KMeansEngine engine(options);
+    KMeansResult result;
+    engine.fit(points, K, result);    // warm-up: grows the buffers and the page cache
+
+    auto start = chrono::steady_clock::now();
+    for (int r = 0; r < runs; ++r) {
+        engine.fit(points, K, result);
+    }
+    chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+
+    BenchmarkTiming timing;
+    timing.label = label;
+    timing.threads = engine.getOptions().threads;
+    timing.millisPerFit = elapsed.count() / runs;
+    timing.iterations = result.getIterations();
+    timing.inertia = result.getInertia();
+    for (int c = 1; c <= K; ++c) {
+        timing.centerX.push_back(result.getCenterX(c));
+        timing.centerY.push_back(result.getCenterY(c));
+    }
+    timing.labels = result.getLabels();
+    timing.elapsedSeconds = result.getElapsedSeconds();
+    timing.threadBusySeconds = result.getThreadBusySeconds();
+    timing.threadSteals = result.getThreadSteals();
+    timing.loadImbalance = result.getLoadImbalance();
+    timing.threadNodes = result.getThreadNodes();
+    timing.threadPoints = result.getThreadPoints();
+    timing.threadRemotePoints = result.getThreadRemotePoints();
+    timing.nodePoints = result.getNodePoints();
+    return timing;
+}
+
+/**
+ * @brief Prints one timing row.
+ * @param timing The timing to print.
+ * @param OUTPUT The stream to print to.
+ */
+void Benchmark::printRow(const BenchmarkTiming& timing, ostream& OUTPUT) {
+    OUTPUT << left << setw(22) << timing.label << right
+           << setw(8) << timing.threads
+           << setw(12) << fixed << setprecision(3) << timing.millisPerFit
+           << setw(12) << timing.millisPerFit / max(1, timing.iterations)
+           << setw(8) << timing.iterations
+           << setw(20) << setprecision(6) << timing.inertia << "\n";
+    OUTPUT.unsetf(ios::fixed);
+}
+
+/**
+ * @brief Compares FAST and DETERMINISTIC reduction and prints a report.
+ * @param base Options shared by both modes.
+ * @param OUTPUT The stream to print to.
+ */
+void Benchmark::compareReductions(const KMeansOptions& base, ostream& OUTPUT) {
+    KMeansOptions fastOptions = base;
+    fastOptions.reduction = ReductionMode::FAST;
+    KMeansOptions deterministicOptions = base;
+    deterministicOptions.reduction = ReductionMode::DETERMINISTIC;
+    KMeansOptions referenceOptions = deterministicOptions;
+    referenceOptions.threads = 1;
+
+    OUTPUT << "Points: " << points.size() << ", K: " << K << ", timed fits per mode: " << runs << "\n"
+           << left << setw(22) << "mode" << right << setw(8) << "threads" << setw(12) << "ms/fit"
+           << setw(12) << "ms/iter" << setw(8) << "iters" << setw(20) << "inertia" << "\n";
+
+    BenchmarkTiming fast = measure("fast", fastOptions);
+    printRow(fast, OUTPUT);
+    BenchmarkTiming deterministic = measure("deterministic", deterministicOptions);
+    printRow(deterministic, OUTPUT);
+    BenchmarkTiming reference = measure("deterministic (1 thr)", referenceOptions);
+    printRow(reference, OUTPUT);
+
+    double overhead = (deterministic.millisPerFit / deterministic.iterations)
+                    / (fast.millisPerFit / fast.iterations) - 1.0;
+    bool identical = deterministic.centerX == reference.centerX && deterministic.centerY == reference.centerY
+                  && deterministic.labels == reference.labels;
+
+    OUTPUT << "Deterministic cost per iteration: " << showpos << fixed << setprecision(1)
+           << overhead * 100.0 << "%" << noshowpos << "\n";
+    OUTPUT.unsetf(ios::fixed);
+    OUTPUT << "Deterministic result identical to 1 thread: " << (identical ? "yes" : "NO") << "\n";
+}
+
+/**
+ * @brief Compares runs with and without NUMA placement.
+ * @param base Options shared by both runs.
+ * @param OUTPUT The stream to print to.
+ */
+void Benchmark::compareNumaPlacement(const KMeansOptions& base, ostream& OUTPUT) {
+    KMeansOptions plainOptions = base;
+    plainOptions.numaPlacement = false;
+    KMeansOptions numaOptions = base;
+    numaOptions.numaPlacement = true;
+
+    NumaTopology topology;
+    OUTPUT << "NUMA topology:\n" << topology
+           << left << setw(22) << "placement" << right << setw(8) << "threads" << setw(12) << "ms/fit"
+           << setw(12) << "ms/iter" << setw(8) << "iters" << setw(20) << "inertia" << "\n";
+
+    BenchmarkTiming plain = measure("single allocation", plainOptions);
+    printRow(plain, OUTPUT);
+    BenchmarkTiming numa = measure("per-node first touch", numaOptions);
+    printRow(numa, OUTPUT);
+
+    // Bytes are those the node's threads actually read (16 per labelled point), including
+    // points they stole from other nodes; "remote" is the share of those.
+    OUTPUT << left << setw(22) << "node" << right << setw(12) << "points" << setw(12) << "threads"
+           << setw(14) << "busy ms" << setw(12) << "GB/s" << setw(10) << "remote" << "\n";
+    for (size_t node = 0; node < numa.nodePoints.size(); ++node) {
+        double slowest = 0.0;
+        int threads = 0;
+        size_t labelled = 0, remote = 0;
+        for (size_t t = 0; t < numa.threadNodes.size(); ++t) {
+            if (numa.threadNodes[t] == static_cast<int>(node)) {
+                slowest = max(slowest, numa.threadBusySeconds[t]);
+                labelled += numa.threadPoints[t];
+                remote += numa.threadRemotePoints[t];
+                ++threads;
+            }
+        }
+        double bytes = 16.0 * labelled;
+        OUTPUT << left << setw(22) << ("node " + to_string(topology.getNodeID(static_cast<int>(node)))) << right
+               << setw(12) << numa.nodePoints[node] << setw(12) << threads
+               << setw(14) << fixed << setprecision(3) << slowest * 1000.0
+               << setw(12) << (slowest > 0.0 ? bytes / slowest / 1e9 : 0.0)
+               << setw(9) << setprecision(1) << (labelled > 0 ? 100.0 * remote / labelled : 0.0) << "%\n";
+        OUTPUT.unsetf(ios::fixed);
+    }
+
+    double speedup = (plain.millisPerFit / plain.iterations) / (numa.millisPerFit / numa.iterations);
+    OUTPUT << "Iteration speedup with NUMA placement: " << fixed << setprecision(2) << speedup << "x\n";
+    OUTPUT.unsetf(ios::fixed);
+}
+
+/**
+ * @brief Prints the busy time and steal count of every thread.
+ * @param base The options to run with.
+ * @param OUTPUT The stream to print to.
+ */
+void Benchmark::reportLoadBalance(const KMeansOptions& base, ostream& OUTPUT) {
+    BenchmarkTiming timing = measure("work stealing", base);
+
+    OUTPUT << left << setw(22) << "thread" << right << setw(8) << "node" << setw(14) << "busy ms"
+           << setw(12) << "steals" << "\n";
+    for (size_t t = 0; t < timing.threadBusySeconds.size(); ++t) {
+        OUTPUT << left << setw(22) << ("thread " + to_string(t)) << right
+               << setw(8) << timing.threadNodes[t]
+               << setw(14) << fixed << setprecision(3) << timing.threadBusySeconds[t] * 1000.0
+               << setw(12) << timing.threadSteals[t] << "\n";
+        OUTPUT.unsetf(ios::fixed);
+    }
+    OUTPUT << "Load imbalance (longest / mean busy time): " << fixed << setprecision(2)
+           << timing.loadImbalance << "\n";
+    OUTPUT.unsetf(ios::fixed);
+}
+
+/**
+ * @brief Generates k Gaussian blobs of points.
+ * @param n The number of points.
+ * @param k The number of blobs.
+ * @param seed Seed of the random generator.
+ * @param xs Receives the x-coordinates.
+ * @param ys Receives the y-coordinates.
+ * @throws invalid_argument If k is not positive.
+ *
+ * Blob centers are drawn uniformly from [0, 100)^2, the same range as 40.txt.
+ */
+void Benchmark::generateBlobs(size_t n, int k, unsigned int seed, vector<double>& xs, vector<double>& ys) {
+    if (k <= 0) {
+        throw invalid_argument("K must be a positive number.");
+    }
+
+    mt19937 generator(seed);
+    uniform_real_distribution<double> position(0.0, 100.0);
+    normal_distribution<double> spread(0.0, 5.0);
+    uniform_int_distribution<int> blob(0, k - 1);
+
+    vector<double> blobX(k), blobY(k);
+    for (int c = 0; c < k; ++c) {
+        blobX[c] = position(generator);
+        blobY[c] = position(generator);
+    }
+
+    xs.resize(n);
+    ys.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        int c = blob(generator);
+        xs[i] = blobX[c] + spread(generator);
+        ys[i] = blobY[c] + spread(generator);
+    }
+}
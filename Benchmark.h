@@ -0,0 +1,127 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+#include <iostream>
+#include <string>
+#include <vector>
+#include "KMeansEngine.h"
+
+using namespace std;
+
+/**
+ * @struct BenchmarkTiming
+ * @brief Timing of one benchmarked engine configuration.
+ */
+struct BenchmarkTiming
+{
+	string label;			///< Name of the configuration.
+	int threads;			///< Threads used by the engine.
+	double millisPerFit;	///< Average wall time of one fit() in milliseconds.
+	int iterations;			///< Iterations of the last fit().
+	double inertia;			///< Inertia of the last fit().
+	vector<double> centerX;	///< Center x-coordinates of the last fit().
+	vector<double> centerY;	///< Center y-coordinates of the last fit().
+	vector<int> labels;		///< Labels of the last fit().
+	double elapsedSeconds;	///< Iteration wall time of the last fit().
+	vector<double> threadBusySeconds;	///< Busy time of every thread in the last fit().
+	vector<size_t> threadSteals;		///< Ranges stolen by every thread in the last fit().
+	double loadImbalance;				///< Longest over mean busy time in the last fit().
+	vector<int> threadNodes;			///< Node index of every thread in the last fit().
+	vector<size_t> threadPoints;		///< Points labelled by every thread in the last fit().
+	vector<size_t> threadRemotePoints;	///< Points of another node labelled by every thread in the last fit().
+	vector<size_t> nodePoints;			///< Points per node in the last fit().
+};
+
+/**
+ * @class Benchmark
+ * @brief Times KMeansEngine configurations on one data set.
+ *
+ * Every configuration gets its own engine, one untimed warm-up fit and then
+ * `runs` timed fits that reuse the same result object.
+ */
+class Benchmark
+{
+	public:
+
+		/**
+     	* @brief Constructs a benchmark.
+     	* @param points The points to cluster; they must outlive the benchmark.
+     	* @param k The number of clusters.
+     	* @param runs The number of timed fits per configuration.
+     	* @throws invalid_argument if runs or k is not positive, or there are fewer than k points.
+     	*/
+		Benchmark(const PointSpan& points, int k, int runs);
+
+		/**
+     	* @brief Times one engine configuration.
+     	* @param label Name printed for the configuration.
+     	* @param options The engine options.
+     	* @return The timing and the outcome of the last fit.
+     	*/
+		BenchmarkTiming measure(const string& label, const KMeansOptions& options);
+
+		/**
+     	* @brief Compares FAST and DETERMINISTIC reduction and prints a report.
+     	* @param base Options shared by both modes (threads, seeding, ...).
+     	* @param OUTPUT The stream to print to.
+     	*
+     	* Also checks that DETERMINISTIC mode reproduces its single-thread result bit for bit.
+     	*/
+		void compareReductions(const KMeansOptions& base, ostream& OUTPUT);
+
+		/**
+     	* @brief Compares runs with and without NUMA placement and prints per-node bandwidth.
+     	* @param base Options shared by both runs (threads, reduction, ...).
+     	* @param OUTPUT The stream to print to.
+     	*
+     	* The bandwidth of a node is the coordinate data its threads stream per fit
+     	* (16 bytes per point and iteration) divided by the busy time of its slowest thread.
+     	*/
+		void compareNumaPlacement(const KMeansOptions& base, ostream& OUTPUT);
+
+		/**
+     	* @brief Prints how evenly the work-stealing scheduler spread the assignment work.
+     	* @param base The options to run with.
+     	* @param OUTPUT The stream to print to.
+     	*
+     	* Lists the busy time and steal count of every thread and the load imbalance
+     	* (longest busy time over the mean; 1.00 is a perfect balance).
+     	*/
+		void reportLoadBalance(const KMeansOptions& base, ostream& OUTPUT);
+
+		/**
+     	* @brief Prints one timing row.
+     	* @param timing The timing to print.
+     	* @param OUTPUT The stream to print to.
+     	*/
+		static void printRow(const BenchmarkTiming& timing, ostream& OUTPUT);
+
+		/**
+     	* @brief Generates k Gaussian blobs of points for benchmarking.
+     	* @param n The number of points.
+     	* @param k The number of blobs.
+     	* @param seed Seed of the random generator.
+     	* @param xs Receives the x-coordinates.
+     	* @param ys Receives the y-coordinates.
+     	* @throws invalid_argument if k is not positive.
+     	*/
+		static void generateBlobs(size_t n, int k, unsigned int seed, vector<double>& xs, vector<double>& ys);
+
+	private:
+
+		/**
+     	* @brief The benchmarked points.
+     	*/
+		PointSpan points;
+
+		/**
+     	* @brief Number of clusters.
+     	*/
+		int K;
+
+		/**
+     	* @brief Timed fits per configuration.
+     	*/
+		int runs;
+};
+
+#endif
@@ -0,0 +1,485 @@
+#include "GnuplotRenderer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#else
+#include <csignal>
+#include <pthread.h>
+#include <sys/wait.h>
+#endif
+
+using namespace std;
+
+/**
+ * @file GnuplotRenderer.cpp
+ * @brief Implementation of the persistent-pipe gnuplot renderer.
+ */
+
+/**
+ * @brief Quotes a string for gnuplot (single quotes, embedded quotes doubled).
+ * @param text The text to quote.
+ * @return The quoted text.
+ */
+static string quote(const string& text) {
+    string quoted = "'";
+    for (char c : text) {
+        quoted += c;
+        if (c == '\'') {
+            quoted += '\'';
+        }
+    }
+    return quoted + "'";
+}
+
+/**
+ * @brief Writes text to a pipe without letting a dead reader kill the process.
+ * @param pipe The pipe to write to.
+ * @param text The text to write.
+ * @return True if the text was written and flushed.
+ *
+ * On POSIX systems SIGPIPE is blocked for the calling thread during the write, so a
+ * reader that has exited makes the write fail with EPIPE instead of terminating the
+ * program; a SIGPIPE raised by the failed write is consumed before the mask is restored.
+ */
+static bool writePipe(FILE* pipe, const string& text) {
+#ifndef _WIN32
+    sigset_t pipeSignal, previous;
+    sigemptyset(&pipeSignal);
+    sigaddset(&pipeSignal, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipeSignal, &previous);
+#endif
+
+    bool written = fputs(text.c_str(), pipe) >= 0;
+    written = fflush(pipe) == 0 && written;
+
+#ifndef _WIN32
+    sigset_t pending;
+    if (!written && sigismember(&previous, SIGPIPE) == 0
+        && sigpending(&pending) == 0 && sigismember(&pending, SIGPIPE) == 1) {
+        int signal;
+        sigwait(&pipeSignal, &signal);
+    }
+    pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+#endif
+    return written;
+}
+
+/**
+ * @brief Converts a pclose() status into the exit code of the process.
+ * @param status The value returned by pclose().
+ * @return The exit code, or -1 if the process was killed or could not be waited for.
+ */
+static int exitCode(int status) {
+#ifdef _WIN32
+    return status;
+#else
+    if (status == -1 || !WIFEXITED(status)) {
+        return -1;
+    }
+    return WEXITSTATUS(status);
+#endif
+}
+
+/**
+ * @brief Picks a distinct color for a cluster.
+ * @param clusterID The cluster ID (1..K).
+ * @return The color as "#rrggbb".
+ *
+ * Hues are spaced by the golden ratio so that neighbouring IDs differ strongly for any K.
+ */
+static string clusterColor(int clusterID) {
+    double hue = fmod((clusterID - 1) * 0.618033988749895, 1.0) * 6.0;
+    double s = 0.75, v = 0.9;
+    int sector = static_cast<int>(hue);
+    double f = hue - sector;
+    double p = v * (1 - s), q = v * (1 - s * f), t = v * (1 - s * (1 - f));
+    double r, g, b;
+    switch (sector) {
+        case 0:  r = v; g = t; b = p; break;
+        case 1:  r = q; g = v; b = p; break;
+        case 2:  r = p; g = v; b = t; break;
+        case 3:  r = p; g = q; b = v; break;
+        case 4:  r = t; g = p; b = v; break;
+        default: r = v; g = p; b = q; break;
+    }
+
+    char color[8];
+    snprintf(color, sizeof(color), "#%02x%02x%02x",
+             static_cast<int>(r * 255), static_cast<int>(g * 255), static_cast<int>(b * 255));
+    return color;
+}
+
+/**
+ * @brief Parses a terminal name.
+ * @param name "window", "png" or "svg".
+ * @return The matching terminal.
+ * @throws invalid_argument If the name is unknown.
+ */
+PlotTerminal parsePlotTerminal(const string& name) {
+    if (name == "window") {
+        return PlotTerminal::WINDOW;
+    }
+    if (name == "png") {
+        return PlotTerminal::PNG;
+    }
+    if (name == "svg") {
+        return PlotTerminal::SVG;
+    }
+    throw invalid_argument("Unknown plot format: " + name);
+}
+
+/**
+ * @brief Constructs the default plot options.
+ */
+PlotOptions::PlotOptions()
+#ifdef _WIN32
+    : gnuplotPath("C:\\Program Files\\gnuplot\\bin\\gnuplot.exe"),
+#else
+    : gnuplotPath("gnuplot"),
+#endif
+      terminal(PlotTerminal::WINDOW), width(1024), height(768),
+      maxPointsPerCluster(20000), densityBins(256), dataPrefix("plot_data") {
+}
+
+/**
+ * @brief Constructs a renderer.
+ * @param options The plot settings.
+ * @throws invalid_argument If the size, bin count or point limit is not positive.
+ */
+GnuplotRenderer::GnuplotRenderer(const PlotOptions& options)
+    : options(options), pipe(nullptr), cachedRevision(0), cachedX(nullptr), cachedY(nullptr),
+      cachedCount(0), renderCount(0) {
+    if (options.width <= 0 || options.height <= 0) {
+        throw invalid_argument("Plot size must be positive.");
+    }
+    if (options.densityBins <= 0 || options.maxPointsPerCluster == 0) {
+        throw invalid_argument("Density bins and the per-cluster point limit must be positive.");
+    }
+}
+
+/**
+ * @brief Destructor. Closes the gnuplot pipe.
+ */
+GnuplotRenderer::~GnuplotRenderer() {
+    try {
+        close();
+    }
+    catch (const exception&) {
+        // A destructor must not throw; call close() first to see gnuplot's errors.
+    }
+}
+
+/**
+ * @brief Checks whether the gnuplot process is running.
+ * @return True if the pipe is open.
+ */
+bool GnuplotRenderer::isOpen(void) const {
+    return pipe != nullptr;
+}
+
+/**
+ * @brief Forces the next render() to rewrite the data files.
+ */
+void GnuplotRenderer::invalidate(void) {
+    cachedRevision = 0;
+    cachedX = nullptr;
+    cachedY = nullptr;
+    cachedCount = 0;
+}
+
+/**
+ * @brief Closes the gnuplot pipe and waits for gnuplot to exit.
+ * @throws runtime_error If gnuplot could not be started, crashed or exited with an error.
+ *
+ * popen() succeeds as long as the shell starts, so a missing gnuplot only shows up
+ * here, as exit code 127 from the shell.
+ */
+void GnuplotRenderer::close(void) {
+    if (pipe == nullptr) {
+        return;
+    }
+
+    writePipe(pipe, "exit\n");
+    int code = exitCode(pclose(pipe));
+    pipe = nullptr;
+    renderCount = 0;
+
+    if (code == 127) {
+        throw runtime_error("Error: Could not start gnuplot: " + options.gnuplotPath);
+    }
+    if (code != 0) {
+        throw runtime_error("Error: gnuplot failed (exit code " + to_string(code) + "): " + options.gnuplotPath);
+    }
+}
+
+/**
+ * @brief Sends commands to gnuplot.
+ * @param commands The command text.
+ * @throws runtime_error If gnuplot is no longer reading; the pipe is closed then.
+ */
+void GnuplotRenderer::sendCommands(const string& commands) {
+    if (writePipe(pipe, commands)) {
+        return;
+    }
+
+    int code = exitCode(pclose(pipe));
+    pipe = nullptr;
+    renderCount = 0;
+    if (code == 127) {
+        throw runtime_error("Error: Could not start gnuplot: " + options.gnuplotPath);
+    }
+    throw runtime_error("Error: gnuplot stopped reading commands (exit code " + to_string(code) + "): "
+                        + options.gnuplotPath);
+}
+
+/**
+ * @brief Starts gnuplot if it is not running yet.
+ * @throws runtime_error If the process cannot be started.
+ *
+ * The interactive terminal is started with -persist so the window outlives the pipe.
+ * A sync file left by an earlier gnuplot is removed first; the sequence numbers of
+ * the new pipe start again at 1 and would otherwise be answered by the stale file.
+ */
+void GnuplotRenderer::openPipe(void) {
+    if (pipe != nullptr) {
+        return;
+    }
+
+    string syncFile = options.dataPrefix + ".sync";
+    if (remove(syncFile.c_str()) != 0) {
+        ifstream stale(syncFile);
+        if (stale) {
+            throw runtime_error("Error: Could not remove file: " + syncFile);
+        }
+    }
+
+    string command = "\"" + options.gnuplotPath + "\"";
+    if (options.terminal == PlotTerminal::WINDOW) {
+        command += " -persist";
+    }
+
+#ifdef _WIN32
+    pipe = popen(command.c_str(), "wb");
+#else
+    pipe = popen(command.c_str(), "w");
+#endif
+    if (pipe == nullptr) {
+        throw runtime_error("Error: Could not start gnuplot: " + options.gnuplotPath);
+    }
+}
+
+/**
+ * @brief Waits until gnuplot has finished every plot command sent so far.
+ * @throws runtime_error If gnuplot does not answer within ten seconds.
+ *
+ * Each render ends by having gnuplot print its sequence number to the sync file;
+ * the data files must not be overwritten before the last number shows up there.
+ */
+void GnuplotRenderer::waitForGnuplot(void) const {
+    if (pipe == nullptr || renderCount == 0) {
+        return;
+    }
+
+    string syncFile = options.dataPrefix + ".sync";
+    for (int attempt = 0; attempt < 10000; ++attempt) {
+        ifstream sync(syncFile);
+        long done = -1;
+        if (sync >> done && done == renderCount) {
+            return;
+        }
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    throw runtime_error("Error: gnuplot did not finish the previous plot.");
+}
+
+/**
+ * @brief Writes a buffer of floats to a binary file.
+ * @param fileName The file to write.
+ * @param values The values to write.
+ * @throws runtime_error If the file cannot be written.
+ */
+void GnuplotRenderer::writeBinary(const string& fileName, const vector<float>& values) const {
+    ofstream outFile(fileName, ios::binary | ios::trunc);
+    if (!outFile.is_open()) {
+        throw runtime_error("Error: Could not open file: " + fileName);
+    }
+
+    outFile.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(float));
+    if (!outFile) {
+        throw runtime_error("Error: Could not write file: " + fileName);
+    }
+}
+
+/**
+ * @brief Writes the per-cluster and center data files.
+ * @param points The clustered points.
+ * @param result The clustering result.
+ *
+ * Points are first grouped by cluster with a counting sort. A cluster within the point
+ * limit is written as raw (x, y) pairs; a larger one is binned on a densityBins^2 grid over
+ * the bounding box of all points and written as one (x, y, point size) record per occupied
+ * bin, the size growing with the logarithm of the bin count.
+ */
+void GnuplotRenderer::writeData(const PointSpan& points, const KMeansResult& result) {
+    const int k = result.getK();
+    const vector<int>& labels = result.getLabels();
+    size_t n = points.size();
+
+    clusterStart.assign(k + 1, 0);
+    for (int c = 1; c <= k; ++c) {
+        clusterStart[c] = clusterStart[c - 1] + result.getClusterSize(c);
+    }
+    order.resize(n);
+    vector<size_t> next(clusterStart.begin(), clusterStart.end() - 1);
+    for (size_t i = 0; i < n; ++i) {
+        order[next[labels[i] - 1]++] = i;
+    }
+
+    double minX = points.x(0), maxX = minX, minY = points.y(0), maxY = minY;
+    for (size_t i = 1; i < n; ++i) {
+        minX = min(minX, points.x(i));
+        maxX = max(maxX, points.x(i));
+        minY = min(minY, points.y(i));
+        maxY = max(maxY, points.y(i));
+    }
+    const int bins = options.densityBins;
+    double binWidth = (maxX - minX) / bins;
+    double binHeight = (maxY - minY) / bins;
+    binCount.assign(static_cast<size_t>(bins) * bins, 0);
+
+    clusterBinned.assign(k, false);
+    for (int c = 0; c < k; ++c) {
+        size_t first = clusterStart[c], last = clusterStart[c + 1];
+        records.clear();
+
+        if (last - first <= options.maxPointsPerCluster) {
+            for (size_t j = first; j < last; ++j) {
+                records.push_back(static_cast<float>(points.x(order[j])));
+                records.push_back(static_cast<float>(points.y(order[j])));
+            }
+        } else {
+            clusterBinned[c] = true;
+            touchedBins.clear();
+            for (size_t j = first; j < last; ++j) {
+                int bx = binWidth > 0 ? min(bins - 1, static_cast<int>((points.x(order[j]) - minX) / binWidth)) : 0;
+                int by = binHeight > 0 ? min(bins - 1, static_cast<int>((points.y(order[j]) - minY) / binHeight)) : 0;
+                size_t bin = static_cast<size_t>(by) * bins + bx;
+                if (binCount[bin]++ == 0) {
+                    touchedBins.push_back(bin);
+                }
+            }
+            for (size_t bin : touchedBins) {
+                double bx = static_cast<double>(bin % bins) + 0.5;
+                double by = static_cast<double>(bin / bins) + 0.5;
+                records.push_back(static_cast<float>(minX + bx * binWidth));
+                records.push_back(static_cast<float>(minY + by * binHeight));
+                records.push_back(static_cast<float>(0.3 + 0.25 * log2(1.0 + binCount[bin])));
+                binCount[bin] = 0;
+            }
+        }
+
+        writeBinary(options.dataPrefix + "_cluster" + to_string(c + 1) + ".bin", records);
+    }
+
+    records.clear();
+    for (int c = 1; c <= k; ++c) {
+        records.push_back(static_cast<float>(result.getCenterX(c)));
+        records.push_back(static_cast<float>(result.getCenterY(c)));
+    }
+    writeBinary(options.dataPrefix + "_centers.bin", records);
+}
+
+/**
+ * @brief Builds the gnuplot commands that draw the cached data files.
+ * @param outputFile The image file to write.
+ * @return The command text.
+ */
+string GnuplotRenderer::buildPlotCommand(const string& outputFile) const {
+    ostringstream cmd;
+
+    if (options.terminal == PlotTerminal::PNG) {
+        cmd << "set terminal pngcairo size " << options.width << "," << options.height << "\n"
+            << "set output " << quote(outputFile) << "\n";
+    } else if (options.terminal == PlotTerminal::SVG) {
+        cmd << "set terminal svg size " << options.width << "," << options.height << "\n"
+            << "set output " << quote(outputFile) << "\n";
+    }
+
+    cmd << "set title 'K-Means Clustering Result'\n"
+        << "set xlabel 'X Coordinate'\n"
+        << "set ylabel 'Y Coordinate'\n";
+    if (clusterBinned.size() > 12) {
+        cmd << "unset key\n";
+    } else {
+        cmd << "set key outside right\n";
+    }
+
+    cmd << "plot ";
+    for (size_t c = 0; c < clusterBinned.size(); ++c) {
+        string file = quote(options.dataPrefix + "_cluster" + to_string(c + 1) + ".bin");
+        string title = "Cluster " + to_string(c + 1);
+        if (clusterBinned[c]) {
+            cmd << file << " binary format='%float%float%float' using 1:2:3 with points pointtype 7 pointsize variable";
+            title += " (binned)";
+        } else {
+            cmd << file << " binary format='%float%float' using 1:2 with points pointtype 7 pointsize 0.6";
+        }
+        cmd << " linecolor rgb '" << clusterColor(static_cast<int>(c) + 1) << "' title " << quote(title) << ", \\\n     ";
+    }
+    cmd << quote(options.dataPrefix + "_centers.bin")
+        << " binary format='%float%float' using 1:2 with points pointtype 2 pointsize 3 linewidth 2"
+        << " linecolor rgb 'black' title 'Centers'\n";
+
+    if (options.terminal != PlotTerminal::WINDOW) {
+        cmd << "unset output\n";
+    }
+    return cmd.str();
+}
+
+/**
+ * @brief Renders a clustering result.
+ * @param points The clustered points.
+ * @param result The clustering result.
+ * @param outputFile The image file to write (PNG and SVG terminals).
+ * @throws invalid_argument If the result does not match the points or no output file is given.
+ * @throws runtime_error If gnuplot cannot be started, has exited or a data file cannot be written.
+ */
+void GnuplotRenderer::render(const PointSpan& points, const KMeansResult& result, const string& outputFile) {
+    if (result.getLabels().size() != points.size() || points.empty()) {
+        throw invalid_argument("Plot data does not match the clustering result.");
+    }
+    if (options.terminal != PlotTerminal::WINDOW && outputFile.empty()) {
+        throw invalid_argument("An output file is required for PNG and SVG plots.");
+    }
+
+    // The points are read in place, so a caller that changes them under the same arrays
+    // and result must call invalidate().
+    bool cached = result.getRevision() != 0 && cachedRevision == result.getRevision()
+               && cachedX == points.xData() && cachedY == points.yData() && cachedCount == points.size();
+    if (!cached) {
+        waitForGnuplot();
+        invalidate();
+        writeData(points, result);
+        cachedRevision = result.getRevision();
+        cachedX = points.xData();
+        cachedY = points.yData();
+        cachedCount = points.size();
+    }
+
+    openPipe();
+    ++renderCount;
+    string command = buildPlotCommand(outputFile)
+                   + "set print " + quote(options.dataPrefix + ".sync") + "\n"
+                   + "print " + to_string(renderCount) + "\n"
+                   + "unset print\n";
+    sendCommands(command);
+}
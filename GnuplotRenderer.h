@@ -0,0 +1,244 @@
+#ifndef GNUPLOTRENDERER_H
+#define GNUPLOTRENDERER_H
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "PointSpan.h"
+#include "KMeansResult.h"
+
+using namespace std;
+
+/**
+ * @brief Where the gnuplot output goes.
+ */
+enum class PlotTerminal
+{
+	WINDOW,	///< Gnuplot's default interactive terminal.
+	PNG,	///< Headless PNG file (pngcairo).
+	SVG		///< Headless SVG file.
+};
+
+/**
+ * @brief Parses a terminal name ("window", "png" or "svg").
+ * @param name The name to parse.
+ * @return The matching terminal.
+ * @throws invalid_argument if the name is unknown.
+ */
+PlotTerminal parsePlotTerminal(const string& name);
+
+/**
+ * @struct PlotOptions
+ * @brief Settings of a GnuplotRenderer.
+ */
+struct PlotOptions
+{
+	/**
+     * @brief Constructs the default options (interactive window, 20000 points per cluster).
+     */
+	PlotOptions();
+
+	/**
+     * @brief Gnuplot executable.
+     */
+	string gnuplotPath;
+
+	/**
+     * @brief Terminal used for every render.
+     */
+	PlotTerminal terminal;
+
+	/**
+     * @brief Image width in pixels (PNG and SVG only).
+     */
+	int width;
+
+	/**
+     * @brief Image height in pixels (PNG and SVG only).
+     */
+	int height;
+
+	/**
+     * @brief Clusters with more members than this are drawn as density bins instead of points.
+     */
+	size_t maxPointsPerCluster;
+
+	/**
+     * @brief Number of density bins along each axis.
+     */
+	int densityBins;
+
+	/**
+     * @brief Path prefix of the binary data files handed to gnuplot.
+     */
+	string dataPrefix;
+};
+
+/**
+ * @class GnuplotRenderer
+ * @brief Draws clustering results through a gnuplot process that stays open between renders.
+ *
+ * Every cluster is written to its own binary file (read by gnuplot with `binary format=`);
+ * large clusters are reduced to one weighted point per occupied density bin, and the
+ * centers get a separate file. The data files are only rewritten when a different fit or
+ * point array is rendered (see KMeansResult::getRevision()), so drawing the same result to
+ * several outputs costs one plot command each.
+ */
+class GnuplotRenderer
+{
+	public:
+
+		/**
+     	* @brief Constructs a renderer. Gnuplot is started on the first render().
+     	* @param options The plot settings.
+     	* @throws invalid_argument if the size, bin count or point limit is not positive.
+     	*/
+		explicit GnuplotRenderer(const PlotOptions& options = PlotOptions());
+
+		/**
+     	* @brief Destructor. Closes the gnuplot pipe, ignoring errors (call close() to see them).
+     	*/
+		~GnuplotRenderer();
+
+		GnuplotRenderer(const GnuplotRenderer&) = delete;
+		GnuplotRenderer& operator=(const GnuplotRenderer&) = delete;
+
+		/**
+     	* @brief Renders a clustering result.
+     	* @param points The clustered points, in the order the result labels them.
+     	* @param result The clustering result.
+     	* @param outputFile The image file to write; ignored by the WINDOW terminal.
+     	* @throws invalid_argument if the result does not match the points.
+     	* @throws runtime_error if gnuplot cannot be started, has exited or a data file cannot be written.
+     	*/
+		void render(const PointSpan& points, const KMeansResult& result, const string& outputFile = "");
+
+		/**
+     	* @brief Forces the next render() to rewrite the data files.
+     	*
+     	* Needed only when the coordinates are changed in place between renders of the same result.
+     	*/
+		void invalidate(void);
+
+		/**
+     	* @brief Closes the gnuplot pipe and waits for gnuplot to finish writing.
+     	* @throws runtime_error if gnuplot was not found, crashed or exited with an error.
+     	*/
+		void close(void);
+
+		/**
+     	* @brief Checks whether the gnuplot process is running.
+     	* @return True if the pipe is open, otherwise false.
+     	*/
+		bool isOpen(void) const;
+
+	private:
+
+		/**
+     	* @brief Starts gnuplot if it is not running yet.
+     	* @throws runtime_error if the process cannot be started.
+     	*/
+		void openPipe(void);
+
+		/**
+     	* @brief Blocks until gnuplot has processed every render sent so far.
+     	* @throws runtime_error if gnuplot does not answer in time.
+     	*/
+		void waitForGnuplot(void) const;
+
+		/**
+     	* @brief Writes commands to the gnuplot pipe.
+     	* @param commands The command text.
+     	* @throws runtime_error if gnuplot has exited; the pipe is closed.
+     	*/
+		void sendCommands(const string& commands);
+
+		/**
+     	* @brief Writes the per-cluster and center data files.
+     	* @param points The clustered points.
+     	* @param result The clustering result.
+     	*/
+		void writeData(const PointSpan& points, const KMeansResult& result);
+
+		/**
+     	* @brief Writes a buffer of floats to a binary file.
+     	* @param fileName The file to write.
+     	* @param values The values to write.
+     	* @throws runtime_error if the file cannot be written.
+     	*/
+		void writeBinary(const string& fileName, const vector<float>& values) const;
+
+		/**
+     	* @brief Builds the gnuplot commands that draw the cached data files.
+     	* @param outputFile The image file to write.
+     	* @return The command text.
+     	*/
+		string buildPlotCommand(const string& outputFile) const;
+
+		/**
+     	* @brief Plot settings.
+     	*/
+		PlotOptions options;
+
+		/**
+     	* @brief Pipe to the gnuplot process, or nullptr when it is not running.
+     	*/
+		FILE* pipe;
+
+		/**
+     	* @brief Revision of the result the data files were written for, 0 if none.
+     	*/
+		unsigned long long cachedRevision;
+
+		/**
+     	* @brief x-coordinate array the data files were written from.
+     	*/
+		const double* cachedX;
+
+		/**
+     	* @brief y-coordinate array the data files were written from.
+     	*/
+		const double* cachedY;
+
+		/**
+     	* @brief Number of points the data files were written for.
+     	*/
+		size_t cachedCount;
+
+		/**
+     	* @brief Number of renders sent to the running gnuplot process.
+     	*/
+		long renderCount;
+
+		/**
+     	* @brief Whether each cluster file holds density bins (true) or raw points (false).
+     	*/
+		vector<bool> clusterBinned;
+
+		/**
+     	* @brief Point indices grouped by cluster.
+     	*/
+		vector<size_t> order;
+
+		/**
+     	* @brief Start of every cluster inside order (K + 1 entries).
+     	*/
+		vector<size_t> clusterStart;
+
+		/**
+     	* @brief Point count of every density bin of the cluster being written.
+     	*/
+		vector<unsigned int> binCount;
+
+		/**
+     	* @brief Bins touched by the cluster being written, so only they are reset.
+     	*/
+		vector<size_t> touchedBins;
+
+		/**
+     	* @brief Staging buffer for one binary file.
+     	*/
+		vector<float> records;
+};
+
+#endif
@@ -5,6 +5,7 @@
 #include <iostream>
 #include <cmath>
 #include <limits>
+#include <sstream>
 #include <stdexcept>
 
 using namespace std;
@@ -14,14 +15,18 @@ using namespace std;
  * @brief Implementation of the KMeans clustering algorithm.
  */
 
+const double KMeans::MAX_COORDINATE = 1e100;
+
 /**
  * @brief Constructs a KMeans object and initializes clusters.
  * @param fileName Name of the input file containing sample data.
  * @param k Number of clusters for the algorithm.
- * @throws invalid_argument If the number of clusters (K) is less than or equal to 0.
+ * @param options Options forwarded to the clustering engine.
+ * @throws invalid_argument If K is not positive or exceeds the number of samples.
+ * @throws runtime_error If the file cannot be opened or contains a malformed line.
  */
-KMeans::KMeans(const string& fileName, int k)
-    : K(k) {
+KMeans::KMeans(const string& fileName, int k, const KMeansOptions& options)
+    : K(k), engine(options) {
     if (K <= 0) {
         throw invalid_argument("K must be a positive number.");
     }
@@ -30,6 +35,24 @@ KMeans::KMeans(const string& fileName, int k)
     initializeClusters();    // Initialize the first clusters
 }
 
+/**
+ * @brief Constructs a KMeans object from sample data in a stream.
+ * @param input Stream holding the sample data, in the file format.
+ * @param k Number of clusters for the algorithm.
+ * @param options Options forwarded to the clustering engine.
+ * @throws invalid_argument If K is not positive or exceeds the number of samples.
+ * @throws runtime_error If the stream contains a malformed line.
+ */
+KMeans::KMeans(istream& input, int k, const KMeansOptions& options)
+    : K(k), engine(options) {
+    if (K <= 0) {
+        throw invalid_argument("K must be a positive number.");
+    }
+
+    loadSamples(input, "input");
+    initializeClusters();
+}
+
 /**
  * @brief Destructor for the KMeans class.
  */
@@ -38,7 +61,7 @@ KMeans::~KMeans() {}
 /**
  * @brief Loads sample data from a file.
  * @param fileName Name of the file containing sample data.
- * @throws runtime_error If the file cannot be opened.
+ * @throws runtime_error If the file cannot be opened or contains a malformed line.
  *
  * The file should have the format:
  * ```
@@ -51,20 +74,63 @@ void KMeans::loadSamples(const string &fileName) {
         throw runtime_error("File not found: " + fileName);
     }
 
-    int index;
-    double x, y;
+    loadSamples(file, fileName);
+
+    file.close();
+}
+
+/**
+ * @brief Loads sample data from a stream.
+ * @param INPUT The stream to read from.
+ * @param sourceName Name of the source, used in error messages.
+ * @throws runtime_error If a line is not exactly "index x y" with coordinates within MAX_COORDINATE.
+ *
+ * Blank lines are skipped and Windows line endings are accepted. Any other line that
+ * does not parse stops the load with its line number, instead of silently dropping
+ * the rest of the data. Larger magnitudes are rejected because the centers and the
+ * inertia are computed from sums that would overflow to infinity.
+ */
+void KMeans::loadSamples(istream& INPUT, const string& sourceName) {
+    string line;
 	
-    while (file >> index >> x >> y) {
+    for (int lineNumber = 1; getline(INPUT, line); ++lineNumber) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.find_first_not_of(" \t") == string::npos) {
+            continue;
+        }
+
+        istringstream fields(line);
+        int index;
+        double x, y;
+        string rest;
+        if (!(fields >> index >> x >> y) || (fields >> rest) || !isfinite(x) || !isfinite(y)) {
+            throw runtime_error(sourceName + ":" + to_string(lineNumber)
+                                + ": expected 'index x y', got '" + line + "'");
+        }
+        if (fabs(x) > MAX_COORDINATE || fabs(y) > MAX_COORDINATE) {
+            throw runtime_error(sourceName + ":" + to_string(lineNumber)
+                                + ": coordinates must be within +-1e100, got '" + line + "'");
+        }
+
         samples.emplace_back(index,-1, x, y); // Create Sample objects and add them to the vector
+        sampleX.push_back(x);
+        sampleY.push_back(y);
     }
-
-    file.close();
 }
 
 /**
  * @brief Initializes clusters using the first K samples.
+ * @throws invalid_argument If there are fewer than K samples.
  */
 void KMeans::initializeClusters() {
+    if (samples.size() < static_cast<size_t>(K)) {
+        throw invalid_argument("K (" + to_string(K) + ") must not exceed the number of samples ("
+                               + to_string(samples.size()) + ").");
+    }
+
+    clusters.clear();
     for (int i = 0; i < K; ++i) {
         clusters.emplace_back(i + 1, samples[i].getXofSample(), samples[i].getYofSample());
     }
@@ -106,39 +172,44 @@ void KMeans::assignSamplesToClusters() {
 /**
  * @brief Updates the centers of all clusters.
  * @return True if any cluster center has changed, false otherwise.
+ *
+ * Every cluster is recalculated, also after the first one that changed.
  */
 bool KMeans::updateClusterCenters() {
+    bool changed = false;
     
 	for (auto &cluster : clusters) {
         if(cluster.calculateCenter())
         {
-        	return true;
+        	changed = true;
 		}
     }
+    
+    return changed;
 } 
 
 /**
  * @brief Runs the K-Means clustering algorithm.
  *
  * Repeatedly assigns samples to clusters and updates cluster centers until no centers change.
+ * The iterations run in the engine on the flat coordinate arrays; afterwards every sample
+ * gets its cluster ID and the clusters are rebuilt around the final centers.
  */
 void KMeans::run() {
-    bool changed;
-    do {
-        changed = false;
+    engine.fit(getPoints(), K, result);
 
-        assignSamplesToClusters(); 		///< Assign samples to the nearest cluster.
+    const vector<int>& labels = result.getLabels();
+    for (size_t i = 0; i < samples.size(); ++i) {
+        samples[i].setClusterID(labels[i]);
+    }
 
-        // Update and check cluster centers
-        // Second way
-        /*for (auto &cluster : clusters) {
-            if (cluster.calculateCenter()) {
-                changed = true;
-            }
-        } */
-        changed = updateClusterCenters(); ///< Update cluster centers.
-        
-    } while (changed);
+    clusters.clear();
+    for (int id = 1; id <= K; ++id) {
+        clusters.emplace_back(id, result.getCenterX(id), result.getCenterY(id));
+    }
+    for (auto &sample : samples) {
+        clusters[sample.getClusterID() - 1].addSample(&sample);
+    }
 }
 
 /**
@@ -174,20 +245,31 @@ void KMeans::saveResultsToFile(const string& outputFile) const
 		throw runtime_error("Error : Could not open file :" + outputFile);		
 	}
 	
-	outFile << "Cluster Values\n";
+	writeResults(outFile);
+        
+        outFile.close();
+}
+
+/**
+ * @brief Writes the detailed clustering results to a stream.
+ * @param OUTPUT The stream to write to.
+ *
+ * This is the content of the file written by saveResultsToFile().
+ */
+void KMeans::writeResults(ostream& OUTPUT) const
+{
+	OUTPUT << "Cluster Values\n";
 	
 	for(const auto& cluster : getClusters())
 	{
-		outFile << cluster;
+		OUTPUT << cluster;
 	}
 	
-	outFile << "Sample Values \n";
+	OUTPUT << "Sample Values \n";
 	 for (const auto& sample : getSamples()) 
 	{
-        outFile << sample;
+        OUTPUT << sample;
     }
-        
-        outFile.close();
 }
 
 /**
@@ -207,11 +289,49 @@ void KMeans::saveResultsForPlotting(const string& plotFile) const {
         throw runtime_error("Error: Could not open file: " + plotFile);
     }
 
+    writePlotData(outFile);
+
+    outFile.close();
+}
+
+/**
+ * @brief Writes the plot-friendly results to a stream.
+ * @param OUTPUT The stream to write to.
+ *
+ * This is the content of the file written by saveResultsForPlotting().
+ */
+void KMeans::writePlotData(ostream& OUTPUT) const {
     // Save data in a plain format: x-coordinate, y-coordinate, cluster ID
     for (const auto& sample : getSamples()) {
-        outFile << sample.getXofSample() << " " 
-                << sample.getYofSample() << " " 
-                << sample.getClusterID() << endl;
+        OUTPUT << sample.getXofSample() << " " 
+               << sample.getYofSample() << " " 
+               << sample.getClusterID() << endl;
+    }
+}
+
+/**
+ * @brief Saves clustering results as comma-separated values.
+ * @param csvFile Name of the output file.
+ * @throws runtime_error If the file cannot be opened.
+ *
+ * The format of the output file is:
+ * ```
+ * index,x,y,cluster
+ * ```
+ */
+void KMeans::saveResultsAsCsv(const string& csvFile) const {
+    ofstream outFile(csvFile);
+
+    if (!outFile.is_open()) {
+        throw runtime_error("Error: Could not open file: " + csvFile);
+    }
+
+    outFile << "index,x,y,cluster\n";
+    for (const auto& sample : getSamples()) {
+        outFile << sample.getIndex() << ","
+                << sample.getXofSample() << ","
+                << sample.getYofSample() << ","
+                << sample.getClusterID() << "\n";
     }
 
     outFile.close();
@@ -235,3 +355,21 @@ const vector<Cluster>& KMeans::getClusters(void) const
 	return clusters;
 }
 
+/**
+ * @brief Gets the raw result of the last run().
+ * @return A constant reference to the engine result.
+ */
+const KMeansResult& KMeans::getResult(void) const
+{
+	return result;
+}
+
+/**
+ * @brief Gets a view of the loaded coordinates.
+ * @return A span over the sample coordinates.
+ */
+PointSpan KMeans::getPoints(void) const
+{
+	return PointSpan(sampleX.data(), sampleY.data(), sampleX.size());
+}
+
@@ -2,6 +2,7 @@
 #define KMEANS_H
 #include <iostream>
 #include "Cluster.h"
+#include "KMeansEngine.h"
 #include <fstream>
 #include <cmath>
 #include <limits>
@@ -21,9 +22,21 @@ class KMeans
      	* @brief Constructor for the KMeans class.
      	* @param fileName The file containing the data points.
      	* @param k The number of clusters to form.
-     	* @throws invalid_argument if k is less than or equal to zero.
+     	* @param options Seeding, threading and iteration options forwarded to the engine.
+     	* @throws invalid_argument if k is less than or equal to zero or exceeds the number of samples.
+     	* @throws runtime_error if the file cannot be opened or contains a malformed line.
      	*/
-		KMeans(const string& fileName, int k);
+		KMeans(const string& fileName, int k, const KMeansOptions& options = KMeansOptions());
+		
+		 /**
+     	* @brief Constructor reading the data points from a stream instead of a file.
+     	* @param input The stream holding the data points, in the file format.
+     	* @param k The number of clusters to form.
+     	* @param options Seeding, threading and iteration options forwarded to the engine.
+     	* @throws invalid_argument if k is less than or equal to zero or exceeds the number of samples.
+     	* @throws runtime_error if the stream contains a malformed line.
+     	*/
+		KMeans(istream& input, int k, const KMeansOptions& options = KMeansOptions());
 		
 		 /**
      	* @brief Destructor for the KMeans class.
@@ -33,12 +46,29 @@ class KMeans
 		 /**
      	* @brief Loads data points (samples) from a file.
      	* @param fileName The name of the file to read data from.
-     	* @throws runtime_error if the file cannot be opened.
+     	* @throws runtime_error if the file cannot be opened or contains a malformed line.
      	*/
 		void loadSamples(const string &fileName);
 		
+		 /**
+     	* @brief Loads data points (samples) from a stream, one "index x y" per line.
+     	* @param INPUT The stream to read data from.
+     	* @param sourceName Name of the data source, used in error messages.
+     	* @throws runtime_error if a non-blank line is malformed or has a coordinate beyond MAX_COORDINATE; the message names the line.
+     	*/
+		void loadSamples(istream& INPUT, const string& sourceName);
+		
+		/**
+     	* @brief Largest accepted coordinate magnitude.
+     	*
+     	* Keeps the per-cluster coordinate sums and the squared distances of the engine
+     	* finite: with |x|, |y| <= 1e100 a squared distance is at most 8e200.
+     	*/
+		static const double MAX_COORDINATE;
+		
 		/**
      	* @brief Initializes clusters using the first k data points as initial centroids.
+     	* @throws invalid_argument if there are fewer than k data points.
      	*/
 		void initializeClusters(void);
 		
@@ -58,7 +88,9 @@ class KMeans
 		/**
      	* @brief Runs the K-Means algorithm until convergence.
      	* 
-     	* The algorithm stops when cluster centroids no longer change.
+     	* The algorithm stops when cluster centroids no longer change. The work is done
+     	* by a KMeansEngine on the loaded coordinates; samples and clusters are then
+     	* updated from its result.
      	*/
 		void run(void);
 		
@@ -74,6 +106,12 @@ class KMeans
      	*/
 		void saveResultsToFile(const string& outputFile) const;
 		
+		/**
+     	* @brief Writes the detailed clustering results to a stream.
+     	* @param OUTPUT The stream to write to.
+     	*/
+		void writeResults(ostream& OUTPUT) const;
+		
 		/**
      	* @brief Saves clustering results for plotting with external tools.
      	* @param plotFile The name of the file to save plot-friendly data.
@@ -82,6 +120,21 @@ class KMeans
      	*/
 		void saveResultsForPlotting(const string& plotFile) const;
 		
+		/**
+     	* @brief Writes the plot-friendly results (x, y, cluster ID per line) to a stream.
+     	* @param OUTPUT The stream to write to.
+     	*/
+		void writePlotData(ostream& OUTPUT) const;
+		
+		/**
+     	* @brief Saves clustering results as comma-separated values.
+     	* @param csvFile The name of the file to save the table.
+     	* @throws runtime_error if the file cannot be opened.
+     	* 
+     	* Writes a header line followed by: index, x-coordinate, y-coordinate, cluster ID.
+     	*/
+		void saveResultsAsCsv(const string& csvFile) const;
+		
 		/**
      	* @brief Gets the list of samples (data points).
      	* @return A constant reference to the vector of samples.
@@ -94,6 +147,18 @@ class KMeans
      	*/
 		const vector<Cluster>& getClusters(void) const;
 		
+		/**
+     	* @brief Gets the raw result of the last run().
+     	* @return A constant reference to the engine result.
+     	*/
+		const KMeansResult& getResult(void) const;
+		
+		/**
+     	* @brief Gets a view of the loaded coordinates, in the order the result labels them.
+     	* @return A span over the sample coordinates.
+     	*/
+		PointSpan getPoints(void) const;
+		
 	private:
 		
 		/**
@@ -110,6 +175,26 @@ class KMeans
      	* @brief Vector of clusters.
      	*/
 		vector<Cluster> clusters;
+		
+		/**
+     	* @brief X-coordinates of the samples, in file order (the engine input).
+     	*/
+		vector<double> sampleX;
+		
+		/**
+     	* @brief Y-coordinates of the samples, in file order (the engine input).
+     	*/
+		vector<double> sampleY;
+		
+		/**
+     	* @brief Engine that performs the clustering.
+     	*/
+		KMeansEngine engine;
+		
+		/**
+     	* @brief Result of the last run().
+     	*/
+		KMeansResult result;
 };
 
 #endif
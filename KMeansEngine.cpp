@@ -0,0 +1,750 @@
+#include "KMeansEngine.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+/**
+ * @file KMeansEngine.cpp
+ * @brief Implementation of the reusable, span-based K-Means engine.
+ */
+
+const size_t KMeansEngine::DETERMINISTIC_CHUNK;
+const size_t KMeansEngine::MIN_GRAIN;
+
+/**
+ * @brief Source of KMeansResult revisions, shared by all engines.
+ */
+static atomic<unsigned long long> lastRevision(0);
+
+/**
+ * @brief Parses a seeding method name.
+ * @param name "first", "random" or "kmeans++".
+ * @return The matching seeding method.
+ * @throws invalid_argument If the name is unknown.
+ */
+SeedingMethod parseSeedingMethod(const string& name) {
+    if (name == "first") {
+        return SeedingMethod::FIRST_K;
+    }
+    if (name == "random") {
+        return SeedingMethod::RANDOM;
+    }
+    if (name == "kmeans++") {
+        return SeedingMethod::KMEANS_PLUS_PLUS;
+    }
+    throw invalid_argument("Unknown seeding method: " + name);
+}
+
+/**
+ * @brief Parses a reduction mode name.
+ * @param name "fast" or "deterministic".
+ * @return The matching reduction mode.
+ * @throws invalid_argument If the name is unknown.
+ */
+ReductionMode parseReductionMode(const string& name) {
+    if (name == "fast") {
+        return ReductionMode::FAST;
+    }
+    if (name == "deterministic") {
+        return ReductionMode::DETERMINISTIC;
+    }
+    throw invalid_argument("Unknown reduction mode: " + name);
+}
+
+/**
+ * @brief Constructs the default options.
+ */
+KMeansOptions::KMeansOptions()
+    : seeding(SeedingMethod::FIRST_K), randomSeed(5489u), threads(1), maxIterations(0),
+      reduction(ReductionMode::FAST), numaPlacement(false), checkInvariants(false) {
+}
+
+/**
+ * @brief Constructs an empty node buffer.
+ */
+KMeansEngine::NodeBuffer::NodeBuffer()
+    : pointCapacity(0), sumCapacity(0), begin(0), end(0), firstSlot(0), lastSlot(0) {
+}
+
+/**
+ * @brief Constructs an engine.
+ * @param options The options used by every subsequent fit().
+ * @throws invalid_argument If the thread count or iteration limit is negative.
+ */
+KMeansEngine::KMeansEngine(const KMeansOptions& options)
+    : slotCount(0), slotStride(0), inlineBusy(0.0) {
+    setOptions(options);
+}
+
+/**
+ * @brief Destructor for the KMeansEngine class.
+ */
+KMeansEngine::~KMeansEngine() {}
+
+/**
+ * @brief Gets the options of the engine.
+ * @return A constant reference to the options.
+ */
+const KMeansOptions& KMeansEngine::getOptions(void) const {
+    return options;
+}
+
+/**
+ * @brief Replaces the options of the engine.
+ * @param newOptions The new options.
+ * @throws invalid_argument If the thread count or iteration limit is negative.
+ */
+void KMeansEngine::setOptions(const KMeansOptions& newOptions) {
+    if (newOptions.threads < 0) {
+        throw invalid_argument("Thread count must not be negative.");
+    }
+    if (newOptions.maxIterations < 0) {
+        throw invalid_argument("Iteration limit must not be negative.");
+    }
+
+    options = newOptions;
+    if (options.threads == 0) {
+        options.threads = max(1u, thread::hardware_concurrency());
+    }
+}
+
+/**
+ * @brief Clusters the points into k clusters.
+ * @param points The points to cluster.
+ * @param k The number of clusters.
+ * @return The result of the run.
+ */
+KMeansResult KMeansEngine::fit(const PointSpan& points, int k) {
+    KMeansResult result;
+    fit(points, k, result);
+    return result;
+}
+
+/**
+ * @brief Clusters the points into k clusters, reusing the storage of an existing result.
+ * @param points The points to cluster.
+ * @param k The number of clusters.
+ * @param result Receives the result of the run.
+ * @throws invalid_argument If k is not positive or there are fewer than k points.
+ *
+ * Each iteration assigns every point to its nearest center and then moves every
+ * center to the mean of its members, until no label changes or no center moves
+ * (or maxIterations is hit).
+ */
+void KMeansEngine::fit(const PointSpan& points, int k, KMeansResult& result) {
+    if (k <= 0) {
+        throw invalid_argument("K must be a positive number.");
+    }
+    if (points.size() < static_cast<size_t>(k)) {
+        throw invalid_argument("K must not exceed the number of samples.");
+    }
+
+    planWork(points.size(), k);
+    startScheduler();
+    if (scheduler) {
+        scheduler->runOnEachWorker([this, &points, k](int worker) { prepareWorker(points, worker, k); });
+    } else {
+        prepareWorker(points, 0, k);
+    }
+
+    result.revision = ++lastRevision;
+    result.K = k;
+    result.labels.resize(points.size());
+    result.sizes.assign(k, 0);
+    result.iterations = 0;
+    result.inertia = 0.0;
+    result.converged = false;
+    seedCenters(points, k, result);
+
+    if (scheduler) {
+        scheduler->resetStats();
+    }
+    inlineBusy = 0.0;
+    workerPoints.assign(workers.size(), 0);
+    workerRemotePoints.assign(workers.size(), 0);
+    auto start = chrono::steady_clock::now();
+
+    bool changed;
+    double previousInertia = numeric_limits<double>::infinity();
+    do {
+        if (options.checkInvariants) {
+            checkCenterX = result.centerX;
+            checkCenterY = result.centerY;
+        }
+        assignAll(points, result);
+        size_t relabeled = 0;
+        for (size_t slot = 0; slot < slotCount; ++slot) {
+            relabeled += partialRelabels[slot];
+        }
+        // FAST mode sums in whatever order the threads took the ranges, so the centers
+        // can differ in the last bits although no label changed; stable labels end the run.
+        changed = updateCenters(result) && (result.iterations == 0 || relabeled > 0);
+        if (options.checkInvariants) {
+            checkIteration(points, result, previousInertia);
+        }
+        previousInertia = result.inertia;
+        ++result.iterations;
+    } while (changed && (options.maxIterations == 0 || result.iterations < options.maxIterations));
+
+    result.converged = !changed;
+    result.elapsedSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    result.threadBusySeconds.resize(workers.size());
+    result.threadSteals.resize(workers.size());
+    result.threadNodes.resize(workers.size());
+    result.threadPoints = workerPoints;
+    result.threadRemotePoints = workerRemotePoints;
+    for (size_t w = 0; w < workers.size(); ++w) {
+        int worker = static_cast<int>(w);
+        result.threadBusySeconds[w] = scheduler ? scheduler->getBusySeconds(worker) : inlineBusy;
+        result.threadSteals[w] = scheduler ? scheduler->getSteals(worker) : 0;
+        result.threadNodes[w] = workers[w].node;
+    }
+    result.nodePoints.resize(nodes.size());
+    for (size_t node = 0; node < nodes.size(); ++node) {
+        result.nodePoints[node] = nodes[node].end - nodes[node].begin;
+    }
+}
+
+/**
+ * @brief Splits the points into nodes, accumulator slots and worker threads.
+ * @param n The number of points.
+ * @param k The number of clusters.
+ *
+ * Without NUMA placement there is a single node. With it, the threads are dealt
+ * round-robin over the nodes and every node receives a contiguous share of the points
+ * proportional to its thread count (aligned to whole chunks in DETERMINISTIC mode, so
+ * the slots and thus the results are the same as without NUMA placement). Each node
+ * then gets one slot per thread (FAST) or per chunk (DETERMINISTIC). The initial share
+ * of a thread is a contiguous part of its node's points (FAST) or slots (DETERMINISTIC);
+ * the scheduler balances the shares from there.
+ */
+void KMeansEngine::planWork(size_t n, int k) {
+    const bool deterministic = options.reduction == ReductionMode::DETERMINISTIC;
+    const int threads = options.threads;
+    const int nodeCount = options.numaPlacement ? min(topology.getNodeCount(), threads) : 1;
+
+    // Pad every accumulator slot to whole 64-byte lines (8 entries, or 16 where
+    // size_t has 4 bytes); the arrays start on a page, so threads never share a line.
+    const size_t lineEntries = 64 / min(sizeof(double), sizeof(size_t));
+    slotStride = (static_cast<size_t>(k) + lineEntries - 1) / lineEntries * lineEntries;
+    nodes.resize(nodeCount);
+    workers.clear();
+    workerBounds.clear();
+    slotBegin.clear();
+    slotNode.clear();
+
+    int threadsBefore = 0;
+    for (int node = 0; node < nodeCount; ++node) {
+        int nodeThreads = threads / nodeCount + (node < threads % nodeCount ? 1 : 0);
+        NodeBuffer& buffer = nodes[node];
+
+        buffer.begin = node == 0 ? 0 : nodes[node - 1].end;
+        buffer.end = n * (threadsBefore + nodeThreads) / threads;
+        if (deterministic && node + 1 < nodeCount) {
+            buffer.end = max(buffer.begin, buffer.end / DETERMINISTIC_CHUNK * DETERMINISTIC_CHUNK);
+        }
+        if (node + 1 == nodeCount) {
+            buffer.end = n;
+        }
+        threadsBefore += nodeThreads;
+
+        size_t size = buffer.end - buffer.begin;
+        buffer.firstSlot = slotNode.size();
+        if (deterministic) {
+            for (size_t first = buffer.begin; first < buffer.end; first += DETERMINISTIC_CHUNK) {
+                slotBegin.push_back(first);
+                slotNode.push_back(node);
+            }
+        } else {
+            slotNode.insert(slotNode.end(), nodeThreads, node);
+        }
+        buffer.lastSlot = slotNode.size();
+
+        size_t nodeSlots = buffer.lastSlot - buffer.firstSlot;
+        size_t first = deterministic ? buffer.firstSlot : buffer.begin;
+        size_t items = deterministic ? nodeSlots : size;
+        const vector<int>& cpus = topology.getCpus(options.numaPlacement ? node : 0);
+        for (int w = 0; w < nodeThreads; ++w) {
+            WorkerPlan plan;
+            plan.node = node;
+            plan.cpu = options.numaPlacement ? cpus[w % cpus.size()] : -1;
+            plan.first = first + items * w / nodeThreads;
+            plan.last = first + items * (w + 1) / nodeThreads;
+            workers.push_back(plan);
+            workerBounds.push_back(plan.first);
+        }
+
+        // Buffers get pages of their own, mapped but not yet touched: they are first
+        // written by the node's own (pinned) workers, which places them on that node.
+        size_t entries = nodeSlots * slotStride;
+        if (buffer.sumCapacity < entries) {
+            buffer.sumX = allocatePageArray<double>(entries);
+            buffer.sumY = allocatePageArray<double>(entries);
+            buffer.count = allocatePageArray<size_t>(entries);
+            buffer.sumCapacity = entries;
+        }
+        if (options.numaPlacement && buffer.pointCapacity < size) {
+            buffer.x = allocatePageArray<double>(size);
+            buffer.y = allocatePageArray<double>(size);
+            buffer.pointCapacity = size;
+        }
+    }
+
+    slotCount = slotNode.size();
+    slotBegin.push_back(n);
+    workerBounds.push_back(workers.back().last);
+    slotSumX.resize(slotCount);
+    slotSumY.resize(slotCount);
+    slotSumCount.resize(slotCount);
+    for (size_t s = 0; s < slotCount; ++s) {
+        NodeBuffer& buffer = nodes[slotNode[s]];
+        size_t offset = (s - buffer.firstSlot) * slotStride;
+        slotSumX[s] = buffer.sumX.get() + offset;
+        slotSumY[s] = buffer.sumY.get() + offset;
+        slotSumCount[s] = buffer.count.get() + offset;
+    }
+    if (partialInertia.size() < slotCount) {
+        partialInertia.resize(slotCount);
+        partialRelabels.resize(slotCount);
+    }
+}
+
+/**
+ * @brief Chooses the initial centers.
+ * @param points The input points.
+ * @param k The number of clusters.
+ * @param result Receives the initial centers.
+ */
+void KMeansEngine::seedCenters(const PointSpan& points, int k, KMeansResult& result) {
+    result.centerX.resize(k);
+    result.centerY.resize(k);
+    size_t n = points.size();
+
+    if (options.seeding == SeedingMethod::FIRST_K) {
+        for (int c = 0; c < k; ++c) {
+            result.centerX[c] = points.x(c);
+            result.centerY[c] = points.y(c);
+        }
+        return;
+    }
+
+    mt19937 generator(options.randomSeed);
+
+    if (options.seeding == SeedingMethod::RANDOM) {
+        // Rejection sampling of k distinct indices; cheap because k is small next to n.
+        vector<size_t> chosen;
+        chosen.reserve(k);
+        uniform_int_distribution<size_t> pick(0, n - 1);
+        while (chosen.size() < static_cast<size_t>(k)) {
+            size_t index = pick(generator);
+            if (find(chosen.begin(), chosen.end(), index) == chosen.end()) {
+                result.centerX[chosen.size()] = points.x(index);
+                result.centerY[chosen.size()] = points.y(index);
+                chosen.push_back(index);
+            }
+        }
+        return;
+    }
+
+    // k-means++: every next center is drawn with probability proportional to
+    // the squared distance to the nearest center chosen so far.
+    seedWeights.resize(n);
+    size_t first = uniform_int_distribution<size_t>(0, n - 1)(generator);
+    result.centerX[0] = points.x(first);
+    result.centerY[0] = points.y(first);
+
+    double total = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        double dx = points.x(i) - result.centerX[0];
+        double dy = points.y(i) - result.centerY[0];
+        seedWeights[i] = dx * dx + dy * dy;
+        total += seedWeights[i];
+    }
+
+    for (int c = 1; c < k; ++c) {
+        size_t next = 0;
+        if (total > 0.0) {
+            double target = uniform_real_distribution<double>(0.0, total)(generator);
+            while (next + 1 < n && target >= seedWeights[next]) {
+                target -= seedWeights[next];
+                ++next;
+            }
+        } else {
+            next = uniform_int_distribution<size_t>(0, n - 1)(generator);
+        }
+
+        result.centerX[c] = points.x(next);
+        result.centerY[c] = points.y(next);
+
+        // The weights are updated in parallel but summed in index order, so the
+        // draws do not depend on the thread count.
+        const double centerX = result.centerX[c];
+        const double centerY = result.centerY[c];
+        WorkStealingScheduler::RangeTask update = [this, &points, centerX, centerY](size_t begin, size_t end, int) {
+            for (size_t i = begin; i < end; ++i) {
+                double dx = points.x(i) - centerX;
+                double dy = points.y(i) - centerY;
+                seedWeights[i] = min(seedWeights[i], dx * dx + dy * dy);
+            }
+        };
+        if (scheduler) {
+            scheduler->parallelFor(n, MIN_GRAIN, update);
+        } else {
+            update(0, n, 0);
+        }
+
+        total = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            total += seedWeights[i];
+        }
+    }
+}
+
+/**
+ * @brief Starts the worker threads of the current plan, or keeps the running ones.
+ *
+ * A single unpinned thread needs no pool: the caller does the work itself. Otherwise
+ * the threads are restarted only when their CPUs or nodes change, so repeated fits
+ * with the same options reuse them (and their pinning).
+ */
+void KMeansEngine::startScheduler(void) {
+    if (options.threads == 1 && !options.numaPlacement) {
+        scheduler.reset();
+        return;
+    }
+
+    vector<int> cpus, workerNodes;
+    for (const WorkerPlan& plan : workers) {
+        cpus.push_back(plan.cpu);
+        workerNodes.push_back(plan.node);
+    }
+    if (scheduler && cpus == schedulerCpus && workerNodes == schedulerNodes) {
+        return;
+    }
+
+    scheduler.reset();
+    scheduler.reset(new WorkStealingScheduler(cpus, workerNodes));
+    schedulerCpus = cpus;
+    schedulerNodes = workerNodes;
+}
+
+/**
+ * @brief First-touch setup of one thread's share.
+ * @param points The input points.
+ * @param worker The index of the worker plan.
+ * @param k The number of clusters.
+ *
+ * Every worker copies exactly the points of its initial share and zeroes the slots it
+ * starts with, so those pages were first touched, and therefore placed, by its own node.
+ */
+void KMeansEngine::prepareWorker(const PointSpan& points, int worker, int k) {
+    const WorkerPlan& plan = workers[worker];
+    const bool deterministic = options.reduction == ReductionMode::DETERMINISTIC;
+
+    if (options.numaPlacement) {
+        NodeBuffer& home = nodes[plan.node];
+        size_t first = deterministic ? slotBegin[plan.first] : plan.first;
+        size_t last = deterministic ? slotBegin[plan.last] : plan.last;
+        copy(points.xData() + first, points.xData() + last, home.x.get() + (first - home.begin));
+        copy(points.yData() + first, points.yData() + last, home.y.get() + (first - home.begin));
+    }
+
+    if (deterministic) {
+        for (size_t slot = plan.first; slot < plan.last; ++slot) {
+            clearSlot(slot, k);
+        }
+    } else {
+        clearSlot(worker, k);
+    }
+}
+
+/**
+ * @brief Clears the partial sums and inertia of one accumulator slot.
+ * @param slot The slot to clear.
+ * @param k The number of clusters.
+ */
+void KMeansEngine::clearSlot(size_t slot, int k) {
+    fill(slotSumX[slot], slotSumX[slot] + k, 0.0);
+    fill(slotSumY[slot], slotSumY[slot] + k, 0.0);
+    fill(slotSumCount[slot], slotSumCount[slot] + k, 0);
+    partialInertia[slot] = 0.0;
+    partialRelabels[slot] = 0;
+}
+
+/**
+ * @brief Assigns a range of points to their nearest center and adds them to a slot.
+ * @param points The input points.
+ * @param node The node whose copy holds the range.
+ * @param first The first point index.
+ * @param last One past the last point index.
+ * @param slot The accumulator slot to add to.
+ * @param result Holds the centers and receives the labels.
+ *
+ * Squared distances are compared; the square root does not change which center
+ * is nearest. Ties go to the lowest cluster ID, as in KMeans::assignSamplesToClusters().
+ * With NUMA placement the coordinates are read from the node-local copy.
+ */
+void KMeansEngine::assignRange(const PointSpan& points, int node, size_t first, size_t last, size_t slot,
+                               KMeansResult& result) {
+    const int k = result.K;
+    const double* cx = result.centerX.data();
+    const double* cy = result.centerY.data();
+    double* sumX = slotSumX[slot];
+    double* sumY = slotSumY[slot];
+    size_t* count = slotSumCount[slot];
+    int* labels = result.labels.data();
+
+    const NodeBuffer& home = nodes[node];
+    PointSpan source = points;
+    size_t base = 0;
+    if (options.numaPlacement) {
+        source = PointSpan(home.x.get(), home.y.get(), home.end - home.begin);
+        base = home.begin;
+    }
+
+    double inertia = 0.0;
+    size_t relabeled = 0;
+    for (size_t i = first; i < last; ++i) {
+        double x = source.x(i - base);
+        double y = source.y(i - base);
+        double minDistance = numeric_limits<double>::max();
+        int best = 0;
+
+        for (int c = 0; c < k; ++c) {
+            double dx = x - cx[c];
+            double dy = y - cy[c];
+            double distance = dx * dx + dy * dy;
+            if (distance < minDistance) {
+                minDistance = distance;
+                best = c;
+            }
+        }
+
+        if (labels[i] != best + 1) {
+            labels[i] = best + 1;
+            ++relabeled;
+        }
+        sumX[best] += x;
+        sumY[best] += y;
+        ++count[best];
+        inertia += minDistance;
+    }
+
+    partialInertia[slot] += inertia;
+    partialRelabels[slot] += relabeled;
+}
+
+/**
+ * @brief Runs one assignment step over all points.
+ * @param points The input points.
+ * @param result Holds the centers and receives the labels.
+ *
+ * In DETERMINISTIC mode the scheduler hands out slots, and a slot is always summed by
+ * one thread in point order, whichever thread that is. In FAST mode it hands out point
+ * ranges and every thread adds them to its own slot; ranges never cross a node boundary
+ * because they are split from the per-node initial shares.
+ */
+void KMeansEngine::assignAll(const PointSpan& points, KMeansResult& result) {
+    const bool deterministic = options.reduction == ReductionMode::DETERMINISTIC;
+    const int k = result.K;
+
+    if (!deterministic) {
+        for (size_t slot = 0; slot < slotCount; ++slot) {
+            clearSlot(slot, k);
+        }
+    }
+
+    WorkStealingScheduler::RangeTask task = [this, &points, &result, deterministic, k](size_t begin, size_t end, int worker) {
+        // Counted here, per piece, because stealing decides which thread reads which node's points.
+        if (deterministic) {
+            for (size_t slot = begin; slot < end; ++slot) {
+                clearSlot(slot, k);
+                assignRange(points, slotNode[slot], slotBegin[slot], slotBegin[slot + 1], slot, result);
+                size_t count = slotBegin[slot + 1] - slotBegin[slot];
+                workerPoints[worker] += count;
+                if (slotNode[slot] != workers[worker].node) {
+                    workerRemotePoints[worker] += count;
+                }
+            }
+        } else {
+            int node = 0;
+            while (nodes[node].end <= begin) {
+                ++node;
+            }
+            assignRange(points, node, begin, end, worker, result);
+            workerPoints[worker] += end - begin;
+            if (node != workers[worker].node) {
+                workerRemotePoints[worker] += end - begin;
+            }
+        }
+    };
+
+    if (!scheduler) {
+        auto start = chrono::steady_clock::now();
+        task(workerBounds.front(), workerBounds.back(), 0);
+        inlineBusy += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return;
+    }
+
+    scheduler->parallelFor(workerBounds, deterministic ? 1 : MIN_GRAIN, task);
+}
+
+/**
+ * @brief Folds all accumulator slots into slot 0 along a fixed pairwise tree.
+ * @param k The number of clusters (entries used in every slot).
+ *
+ * Slot s absorbs slot s + width for width = 1, 2, 4, ... The tree depends only on
+ * the number of slots, i.e. on the number of points, never on the thread count.
+ */
+void KMeansEngine::treeReduce(int k) {
+    for (size_t width = 1; width < slotCount; width *= 2) {
+        for (size_t s = 0; s + width < slotCount; s += 2 * width) {
+            double* sumX = slotSumX[s];
+            double* sumY = slotSumY[s];
+            size_t* count = slotSumCount[s];
+            const double* otherX = slotSumX[s + width];
+            const double* otherY = slotSumY[s + width];
+            const size_t* otherCount = slotSumCount[s + width];
+
+            for (size_t c = 0; c < static_cast<size_t>(k); ++c) {
+                sumX[c] += otherX[c];
+                sumY[c] += otherY[c];
+                count[c] += otherCount[c];
+            }
+            partialInertia[s] += partialInertia[s + width];
+        }
+    }
+}
+
+/**
+ * @brief Merges the partial sums and recomputes the centers.
+ * @param result Holds the centers to update.
+ * @return True if any center changed.
+ *
+ * The per-point part of the update step, adding every point to its cluster's sums, is
+ * fused into assignRange() and therefore runs on the scheduler with the assignment.
+ * What is left here touches only slots * K entries (a few thousand even for millions of
+ * points) and runs on the calling thread; scheduling it would cost more than it saves.
+ * A cluster that lost all of its members keeps its previous center, like Cluster::calculateCenter().
+ */
+bool KMeansEngine::updateCenters(KMeansResult& result) {
+    size_t slots = slotCount;
+    if (options.reduction == ReductionMode::DETERMINISTIC) {
+        treeReduce(result.K);
+        slots = 1;
+    }
+
+    bool changed = false;
+    result.inertia = 0.0;
+    for (size_t s = 0; s < slots; ++s) {
+        result.inertia += partialInertia[s];
+    }
+
+    for (int c = 0; c < result.K; ++c) {
+        double sumX = 0.0, sumY = 0.0;
+        size_t count = 0;
+        for (size_t s = 0; s < slots; ++s) {
+            sumX += slotSumX[s][c];
+            sumY += slotSumY[s][c];
+            count += slotSumCount[s][c];
+        }
+
+        result.sizes[c] = count;
+        if (count == 0) {
+            continue;
+        }
+
+        double newCenterX = sumX / count;
+        double newCenterY = sumY / count;
+        if (newCenterX != result.centerX[c] || newCenterY != result.centerY[c]) {
+            changed = true;
+        }
+        result.centerX[c] = newCenterX;
+        result.centerY[c] = newCenterY;
+    }
+
+    return changed;
+}
+
+/**
+ * @brief Verifies the invariants of the iteration that just finished.
+ * @param points The input points.
+ * @param result The result after the update step.
+ * @param previousInertia Inertia of the previous iteration (infinity for the first one).
+ * @throws logic_error If an invariant does not hold.
+ *
+ * Everything is recomputed serially from the input, so the check does not share code
+ * paths with the parallel assignment and reduction it guards. The tolerances only absorb
+ * rounding from a different summation order:
+ * - every label is in 1..K and names a nearest center of those the points were assigned to;
+ * - the member counts match the labels and the inertia matches the labelled distances;
+ * - the inertia did not increase (each Lloyd step can only lower it);
+ * - every non-empty cluster's center is the mean of its members.
+ */
+void KMeansEngine::checkIteration(const PointSpan& points, const KMeansResult& result, double previousInertia) const {
+    const int k = result.K;
+    const size_t n = points.size();
+    const string where = "Invariant violated in iteration " + to_string(result.iterations + 1) + ": ";
+
+    vector<size_t> sizes(k, 0);
+    vector<double> sumX(k, 0.0), sumY(k, 0.0), absX(k, 0.0), absY(k, 0.0);
+    double inertia = 0.0;
+
+    for (size_t i = 0; i < n; ++i) {
+        int label = result.labels[i];
+        if (label < 1 || label > k) {
+            throw logic_error(where + "point " + to_string(i) + " has label " + to_string(label));
+        }
+
+        double nearest = numeric_limits<double>::max();
+        for (int c = 0; c < k; ++c) {
+            double dx = points.x(i) - checkCenterX[c];
+            double dy = points.y(i) - checkCenterY[c];
+            nearest = min(nearest, dx * dx + dy * dy);
+        }
+        double dx = points.x(i) - checkCenterX[label - 1];
+        double dy = points.y(i) - checkCenterY[label - 1];
+        double distance = dx * dx + dy * dy;
+        if (distance > nearest * (1.0 + 1e-12) + 1e-300) {
+            throw logic_error(where + "point " + to_string(i) + " is not assigned to a nearest center");
+        }
+
+        ++sizes[label - 1];
+        sumX[label - 1] += points.x(i);
+        sumY[label - 1] += points.y(i);
+        absX[label - 1] += fabs(points.x(i));
+        absY[label - 1] += fabs(points.y(i));
+        inertia += distance;
+    }
+
+    if (fabs(inertia - result.inertia) > 1e-9 * inertia + 1e-12) {
+        throw logic_error(where + "inertia " + to_string(result.inertia) + " differs from " + to_string(inertia));
+    }
+    if (result.inertia > previousInertia * (1.0 + 1e-9) + 1e-12) {
+        throw logic_error(where + "inertia rose from " + to_string(previousInertia) + " to " + to_string(result.inertia));
+    }
+
+    for (int c = 0; c < k; ++c) {
+        if (sizes[c] != result.sizes[c]) {
+            throw logic_error(where + "cluster " + to_string(c + 1) + " counts " + to_string(result.sizes[c])
+                              + " members, labels give " + to_string(sizes[c]));
+        }
+        if (sizes[c] == 0) {
+            continue;
+        }
+        double meanX = sumX[c] / sizes[c];
+        double meanY = sumY[c] / sizes[c];
+        if (fabs(result.centerX[c] - meanX) > 1e-9 * (absX[c] / sizes[c]) + 1e-12
+            || fabs(result.centerY[c] - meanY) > 1e-9 * (absY[c] / sizes[c]) + 1e-12) {
+            throw logic_error(where + "center of cluster " + to_string(c + 1) + " is not the mean of its members");
+        }
+    }
+}
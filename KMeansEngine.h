@@ -0,0 +1,427 @@
+#ifndef KMEANSENGINE_H
+#define KMEANSENGINE_H
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "PointSpan.h"
+#include "KMeansResult.h"
+#include "NumaTopology.h"
+#include "WorkStealingScheduler.h"
+
+using namespace std;
+
+/**
+ * @brief Strategy used to pick the initial cluster centers.
+ */
+enum class SeedingMethod
+{
+	FIRST_K,		///< The first K points, as in the original lab implementation.
+	RANDOM,			///< K distinct points chosen uniformly at random.
+	KMEANS_PLUS_PLUS	///< k-means++ (D^2 weighted) seeding.
+};
+
+/**
+ * @brief Parses a seeding method name ("first", "random" or "kmeans++").
+ * @param name The name to parse.
+ * @return The matching seeding method.
+ * @throws invalid_argument if the name is unknown.
+ */
+SeedingMethod parseSeedingMethod(const string& name);
+
+/**
+ * @brief How the per-thread partial sums of the update step are combined.
+ */
+enum class ReductionMode
+{
+	FAST,			///< One accumulator per thread, merged in thread order; with several threads the low bits may vary between runs.
+	DETERMINISTIC	///< Fixed-size chunks merged along a fixed pairwise tree; results are identical for any thread count.
+};
+
+/**
+ * @brief Parses a reduction mode name ("fast" or "deterministic").
+ * @param name The name to parse.
+ * @return The matching reduction mode.
+ * @throws invalid_argument if the name is unknown.
+ */
+ReductionMode parseReductionMode(const string& name);
+
+/**
+ * @struct KMeansOptions
+ * @brief Tunable parameters of a KMeansEngine.
+ */
+struct KMeansOptions
+{
+	/**
+     * @brief Constructs the default options (first-K seeding, one thread, run until convergence).
+     */
+	KMeansOptions();
+
+	/**
+     * @brief How the initial centers are chosen.
+     */
+	SeedingMethod seeding;
+
+	/**
+     * @brief Seed of the random generator used by RANDOM and KMEANS_PLUS_PLUS seeding.
+     */
+	unsigned int randomSeed;
+
+	/**
+     * @brief Number of threads used by the assignment step (at least 1).
+     */
+	int threads;
+
+	/**
+     * @brief Maximum number of iterations; 0 runs until the centers stop moving.
+     */
+	int maxIterations;
+
+	/**
+     * @brief How partial sums are combined into the new centers.
+     */
+	ReductionMode reduction;
+
+	/**
+     * @brief Copy the points into per-NUMA-node buffers and pin every thread to a CPU of its node.
+     */
+	bool numaPlacement;
+
+	/**
+     * @brief Verify the Lloyd invariants after every iteration (slow; for testing the fast paths).
+     *
+     * Checks that every label is in range and names a nearest previous center, that the
+     * inertia matches the labels and never increases, and that every non-empty cluster's
+     * center is the mean of its members. A violation throws logic_error.
+     */
+	bool checkInvariants;
+};
+
+/**
+ * @class KMeansEngine
+ * @brief Reusable K-Means solver working directly on caller-owned coordinate arrays.
+ *
+ * The engine keeps its scratch buffers (per-thread partial sums, seeding weights,
+ * node-local point copies) and its worker threads between fit() calls, so repeated
+ * fits with different data or K only grow them when a larger problem arrives.
+ * With more than one thread the assignment step runs on a WorkStealingScheduler.
+ */
+class KMeansEngine
+{
+	public:
+
+		/**
+     	* @brief Constructs an engine.
+     	* @param options The options used by every subsequent fit().
+     	* @throws invalid_argument if options.threads or options.maxIterations is negative.
+     	*/
+		explicit KMeansEngine(const KMeansOptions& options = KMeansOptions());
+
+		/**
+     	* @brief Destructor for the KMeansEngine class.
+     	*/
+		~KMeansEngine();
+
+		KMeansEngine(const KMeansEngine&) = delete;
+		KMeansEngine& operator=(const KMeansEngine&) = delete;
+
+		/**
+     	* @brief Clusters the points into k clusters.
+     	* @param points The points to cluster; they are read in place.
+     	* @param k The number of clusters to form.
+     	* @return The result of the run.
+     	* @throws invalid_argument if k is not positive or there are fewer than k points.
+     	*/
+		KMeansResult fit(const PointSpan& points, int k);
+
+		/**
+     	* @brief Clusters the points into k clusters, reusing the storage of an existing result.
+     	* @param points The points to cluster; they are read in place.
+     	* @param k The number of clusters to form.
+     	* @param result Receives the result of the run.
+     	* @throws invalid_argument if k is not positive or there are fewer than k points.
+     	*/
+		void fit(const PointSpan& points, int k, KMeansResult& result);
+
+		/**
+     	* @brief Gets the options of the engine.
+     	* @return A constant reference to the options.
+     	*/
+		const KMeansOptions& getOptions(void) const;
+
+		/**
+     	* @brief Replaces the options of the engine. Buffers are kept.
+     	* @param newOptions The new options.
+     	* @throws invalid_argument if newOptions.threads or newOptions.maxIterations is negative.
+     	*/
+		void setOptions(const KMeansOptions& newOptions);
+
+		/**
+     	* @brief Number of points per accumulator slot in DETERMINISTIC mode.
+     	*
+     	* Changing it changes the summation order and therefore the low bits of the results.
+     	*/
+		static const size_t DETERMINISTIC_CHUNK = 4096;
+
+		/**
+     	* @brief Points a FAST mode assignment or seeding piece covers: threads look for idle threads
+     	* to split work for after every piece, and never split a range below it.
+     	*/
+		static const size_t MIN_GRAIN = 1024;
+
+	private:
+
+		/**
+     	* @struct WorkerPlan
+     	* @brief The initial share of one assignment thread; other threads may steal parts of it.
+     	*/
+		struct WorkerPlan
+		{
+			int node;			///< Index of the node whose points the thread reads.
+			int cpu;			///< CPU the thread is pinned to, or -1 when not pinned.
+			size_t first;		///< First point (FAST) or slot (DETERMINISTIC) of the share.
+			size_t last;		///< One past the last point or slot of the share.
+		};
+
+		/**
+     	* @struct PageDeleter
+     	* @brief Releases arrays allocated with NumaTopology::allocatePages().
+     	*/
+		struct PageDeleter
+		{
+			size_t bytes;	///< Size passed to allocatePages().
+
+			void operator()(void* memory) const { NumaTopology::freePages(memory, bytes); }
+		};
+
+		/**
+     	* @brief Array on pages of its own, placed by first touch.
+     	*/
+		template <typename T>
+		using PageArray = unique_ptr<T[], PageDeleter>;
+
+		/**
+     	* @brief Allocates a PageArray without initialising it.
+     	* @param count The number of elements.
+     	* @return The array; page-aligned, so also aligned to cache lines.
+     	*/
+		template <typename T>
+		static PageArray<T> allocatePageArray(size_t count)
+		{
+			PageDeleter deleter = { count * sizeof(T) };
+			return PageArray<T>(static_cast<T*>(NumaTopology::allocatePages(deleter.bytes)), deleter);
+		}
+
+		/**
+     	* @struct NodeBuffer
+     	* @brief Points and partial sums that belong to one NUMA node.
+     	*/
+		struct NodeBuffer
+		{
+			NodeBuffer();
+
+			PageArray<double> x;			///< Node-local copy of the x-coordinates (NUMA placement only).
+			PageArray<double> y;			///< Node-local copy of the y-coordinates (NUMA placement only).
+			size_t pointCapacity;			///< Points the copies can hold.
+			PageArray<double> sumX;			///< Partial x sums of the node's slots, slotStride entries each.
+			PageArray<double> sumY;			///< Partial y sums of the node's slots, slotStride entries each.
+			PageArray<size_t> count;		///< Partial member counts of the node's slots, slotStride entries each.
+			size_t sumCapacity;				///< Entries the partial sum arrays can hold.
+			size_t begin;					///< First point index of the node.
+			size_t end;						///< One past the last point index of the node.
+			size_t firstSlot;				///< First accumulator slot of the node.
+			size_t lastSlot;				///< One past the last accumulator slot of the node.
+		};
+
+		/**
+     	* @brief Chooses the initial centers according to the seeding option.
+     	* @param points The input points.
+     	* @param k The number of clusters.
+     	* @param result Receives the initial centers.
+     	*/
+		void seedCenters(const PointSpan& points, int k, KMeansResult& result);
+
+		/**
+     	* @brief Splits the points into nodes, accumulator slots and worker threads, and sizes the buffers.
+     	* @param n The number of points.
+     	* @param k The number of clusters.
+     	*/
+		void planWork(size_t n, int k);
+
+		/**
+     	* @brief Starts (or keeps) the worker threads that match the current plan.
+     	*/
+		void startScheduler(void);
+
+		/**
+     	* @brief Copies the points of one worker into its node-local buffer and zeroes its slots (first touch).
+     	* @param points The input points.
+     	* @param worker The index of the worker plan.
+     	* @param k The number of clusters.
+     	*/
+		void prepareWorker(const PointSpan& points, int worker, int k);
+
+		/**
+     	* @brief Clears the partial sums and inertia of one accumulator slot.
+     	* @param slot The slot to clear.
+     	* @param k The number of clusters.
+     	*/
+		void clearSlot(size_t slot, int k);
+
+		/**
+     	* @brief Assigns a range of points to their nearest center and adds them to an accumulator slot.
+     	* @param points The input points.
+     	* @param node The node whose copy holds the range (used with NUMA placement).
+     	* @param first The first point index.
+     	* @param last One past the last point index.
+     	* @param slot The accumulator written.
+     	* @param result Holds the current centers and receives the labels.
+     	*/
+		void assignRange(const PointSpan& points, int node, size_t first, size_t last, size_t slot, KMeansResult& result);
+
+		/**
+     	* @brief Runs one assignment step over all points, in parallel when there are several threads.
+     	* @param points The input points.
+     	* @param result Holds the current centers and receives the labels.
+     	*/
+		void assignAll(const PointSpan& points, KMeansResult& result);
+
+		/**
+     	* @brief Folds every accumulator slot into slot 0 along a fixed pairwise tree.
+     	* @param k The number of clusters.
+     	*/
+		void treeReduce(int k);
+
+		/**
+     	* @brief Merges the partial sums and moves every center to the mean of its members.
+     	* @param result Holds the centers to update.
+     	* @return True if any center changed, otherwise false.
+     	*/
+		bool updateCenters(KMeansResult& result);
+
+		/**
+     	* @brief Verifies the invariants of the iteration that just finished.
+     	* @param points The input points.
+     	* @param result The result after the update step.
+     	* @param previousInertia Inertia of the previous iteration, or infinity for the first one.
+     	* @throws logic_error if an invariant does not hold.
+     	*/
+		void checkIteration(const PointSpan& points, const KMeansResult& result, double previousInertia) const;
+
+		/**
+     	* @brief Options used by fit().
+     	*/
+		KMeansOptions options;
+
+		/**
+     	* @brief NUMA layout of the machine.
+     	*/
+		NumaTopology topology;
+
+		/**
+     	* @brief Number of accumulator slots of the current fit (one per thread in FAST mode, per chunk in DETERMINISTIC mode).
+     	*/
+		size_t slotCount;
+
+		/**
+     	* @brief Distance between consecutive accumulator slots, padded to whole cache lines.
+     	*/
+		size_t slotStride;
+
+		/**
+     	* @brief Buffers of every node in use (a single one without NUMA placement).
+     	*/
+		vector<NodeBuffer> nodes;
+
+		/**
+     	* @brief Work of every assignment thread.
+     	*/
+		vector<WorkerPlan> workers;
+
+		/**
+     	* @brief Initial share boundaries handed to the scheduler (workers.size() + 1 entries).
+     	*/
+		vector<size_t> workerBounds;
+
+		/**
+     	* @brief Worker threads; null when a single unpinned thread does all the work.
+     	*/
+		unique_ptr<WorkStealingScheduler> scheduler;
+
+		/**
+     	* @brief CPU of every scheduler thread, to detect when the threads must be restarted.
+     	*/
+		vector<int> schedulerCpus;
+
+		/**
+     	* @brief Node of every scheduler thread, to detect when the threads must be restarted.
+     	*/
+		vector<int> schedulerNodes;
+
+		/**
+     	* @brief Busy time of the calling thread during the current fit when there is no scheduler.
+     	*/
+		double inlineBusy;
+
+		/**
+     	* @brief Points labelled by every worker during the current fit.
+     	*/
+		vector<size_t> workerPoints;
+
+		/**
+     	* @brief Points of another node labelled by every worker during the current fit.
+     	*/
+		vector<size_t> workerRemotePoints;
+
+		/**
+     	* @brief First point index of every DETERMINISTIC mode slot, plus the point count as a sentinel.
+     	*/
+		vector<size_t> slotBegin;
+
+		/**
+     	* @brief Node index of every slot.
+     	*/
+		vector<int> slotNode;
+
+		/**
+     	* @brief Partial x sums of every slot (points into the node buffers).
+     	*/
+		vector<double*> slotSumX;
+
+		/**
+     	* @brief Partial y sums of every slot (points into the node buffers).
+     	*/
+		vector<double*> slotSumY;
+
+		/**
+     	* @brief Partial member counts of every slot (points into the node buffers).
+     	*/
+		vector<size_t*> slotSumCount;
+
+		/**
+     	* @brief Per-slot partial inertia.
+     	*/
+		vector<double> partialInertia;
+
+		/**
+     	* @brief Per-slot number of points whose label changed in the current iteration.
+     	*/
+		vector<size_t> partialRelabels;
+
+		/**
+     	* @brief Squared distances to the nearest chosen center, used by k-means++ seeding.
+     	*/
+		vector<double> seedWeights;
+
+		/**
+     	* @brief Centers before the current iteration's assignment, kept when checkInvariants is set.
+     	*/
+		vector<double> checkCenterX;
+
+		/**
+     	* @brief See checkCenterX.
+     	*/
+		vector<double> checkCenterY;
+};
+
+#endif
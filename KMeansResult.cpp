@@ -0,0 +1,230 @@
+#include "KMeansResult.h"
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+/**
+ * @file KMeansResult.cpp
+ * @brief Implementation of the move-only KMeansResult container.
+ */
+
+/**
+ * @brief Constructs an empty result.
+ */
+KMeansResult::KMeansResult()
+    : K(0), iterations(0), inertia(0.0), converged(false), elapsedSeconds(0.0), revision(0) {
+}
+
+/**
+ * @brief Move constructor.
+ * @param other The result to take the buffers from.
+ */
+KMeansResult::KMeansResult(KMeansResult&& other)
+    : K(other.K),
+      centerX(move(other.centerX)),
+      centerY(move(other.centerY)),
+      sizes(move(other.sizes)),
+      labels(move(other.labels)),
+      iterations(other.iterations),
+      inertia(other.inertia),
+      converged(other.converged),
+      elapsedSeconds(other.elapsedSeconds),
+      threadBusySeconds(move(other.threadBusySeconds)),
+      threadSteals(move(other.threadSteals)),
+      threadNodes(move(other.threadNodes)),
+      threadPoints(move(other.threadPoints)),
+      threadRemotePoints(move(other.threadRemotePoints)),
+      nodePoints(move(other.nodePoints)),
+      revision(other.revision) {
+    other.K = 0;
+    other.iterations = 0;
+    other.inertia = 0.0;
+    other.converged = false;
+    other.elapsedSeconds = 0.0;
+    other.revision = 0;
+}
+
+/**
+ * @brief Move assignment.
+ * @param other The result to take the buffers from.
+ * @return A reference to this result.
+ */
+KMeansResult& KMeansResult::operator=(KMeansResult&& other) {
+    if (this != &other) {
+        K = other.K;
+        centerX = move(other.centerX);
+        centerY = move(other.centerY);
+        sizes = move(other.sizes);
+        labels = move(other.labels);
+        iterations = other.iterations;
+        inertia = other.inertia;
+        converged = other.converged;
+        elapsedSeconds = other.elapsedSeconds;
+        threadBusySeconds = move(other.threadBusySeconds);
+        threadSteals = move(other.threadSteals);
+        threadNodes = move(other.threadNodes);
+        threadPoints = move(other.threadPoints);
+        threadRemotePoints = move(other.threadRemotePoints);
+        nodePoints = move(other.nodePoints);
+        revision = other.revision;
+
+        other.K = 0;
+        other.iterations = 0;
+        other.inertia = 0.0;
+        other.converged = false;
+        other.elapsedSeconds = 0.0;
+        other.revision = 0;
+    }
+    return *this;
+}
+
+/**
+ * @brief Gets the number of clusters.
+ * @return K.
+ */
+int KMeansResult::getK(void) const {
+    return K;
+}
+
+/**
+ * @brief Gets the x-coordinate of a cluster center.
+ * @param clusterID The cluster ID (1..K).
+ * @return The x-coordinate.
+ */
+double KMeansResult::getCenterX(int clusterID) const {
+    return centerX.at(clusterID - 1);
+}
+
+/**
+ * @brief Gets the y-coordinate of a cluster center.
+ * @param clusterID The cluster ID (1..K).
+ * @return The y-coordinate.
+ */
+double KMeansResult::getCenterY(int clusterID) const {
+    return centerY.at(clusterID - 1);
+}
+
+/**
+ * @brief Gets the cluster ID of every input point.
+ * @return A constant reference to the labels.
+ */
+const vector<int>& KMeansResult::getLabels(void) const {
+    return labels;
+}
+
+/**
+ * @brief Gets the number of points assigned to a cluster.
+ * @param clusterID The cluster ID (1..K).
+ * @return The member count.
+ */
+size_t KMeansResult::getClusterSize(int clusterID) const {
+    return sizes.at(clusterID - 1);
+}
+
+/**
+ * @brief Gets the number of iterations performed.
+ * @return The iteration count.
+ */
+int KMeansResult::getIterations(void) const {
+    return iterations;
+}
+
+/**
+ * @brief Gets the sum of squared point-to-center distances.
+ * @return The inertia.
+ */
+double KMeansResult::getInertia(void) const {
+    return inertia;
+}
+
+/**
+ * @brief Checks whether the run converged.
+ * @return True if the centers stopped moving.
+ */
+bool KMeansResult::hasConverged(void) const {
+    return converged;
+}
+
+/**
+ * @brief Gets the wall time of the iterations.
+ * @return The time in seconds.
+ */
+double KMeansResult::getElapsedSeconds(void) const {
+    return elapsedSeconds;
+}
+
+/**
+ * @brief Gets the busy time of every assignment thread.
+ * @return The busy times in seconds.
+ */
+const vector<double>& KMeansResult::getThreadBusySeconds(void) const {
+    return threadBusySeconds;
+}
+
+/**
+ * @brief Gets the number of work ranges every assignment thread stole.
+ * @return The steal counts.
+ */
+const vector<size_t>& KMeansResult::getThreadSteals(void) const {
+    return threadSteals;
+}
+
+/**
+ * @brief Gets the load imbalance of the assignment threads.
+ * @return The longest busy time divided by the mean busy time.
+ *
+ * 1.0 means every thread worked equally long; with T threads the worst case is T.
+ * A run without measurable work reports 1.0.
+ */
+double KMeansResult::getLoadImbalance(void) const {
+    double longest = 0.0, total = 0.0;
+    for (double busy : threadBusySeconds) {
+        longest = max(longest, busy);
+        total += busy;
+    }
+    if (total <= 0.0) {
+        return 1.0;
+    }
+    return longest * threadBusySeconds.size() / total;
+}
+
+/**
+ * @brief Gets the node index of every assignment thread.
+ * @return The node indices.
+ */
+const vector<int>& KMeansResult::getThreadNodes(void) const {
+    return threadNodes;
+}
+
+/**
+ * @brief Gets the number of points every assignment thread labelled.
+ * @return The point counts.
+ */
+const vector<size_t>& KMeansResult::getThreadPoints(void) const {
+    return threadPoints;
+}
+
+/**
+ * @brief Gets the number of points of another node every assignment thread labelled.
+ * @return The remote point counts.
+ */
+const vector<size_t>& KMeansResult::getThreadRemotePoints(void) const {
+    return threadRemotePoints;
+}
+
+/**
+ * @brief Gets the number of points placed on every node.
+ * @return The point counts.
+ */
+const vector<size_t>& KMeansResult::getNodePoints(void) const {
+    return nodePoints;
+}
+
+/**
+ * @brief Gets the revision of the fit that produced the result.
+ * @return The revision, or 0 if the result was never fitted.
+ */
+unsigned long long KMeansResult::getRevision(void) const {
+    return revision;
+}
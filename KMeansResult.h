@@ -0,0 +1,231 @@
+#ifndef KMEANSRESULT_H
+#define KMEANSRESULT_H
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @class KMeansResult
+ * @brief Holds the outcome of one KMeansEngine::fit() call.
+ *
+ * Results are move-only: the label array is as long as the input, so accidental
+ * copies are rejected at compile time. Cluster IDs follow the rest of the project
+ * and run from 1 to K.
+ */
+class KMeansResult
+{
+	friend class KMeansEngine;
+
+	public:
+
+		/**
+     	* @brief Constructs an empty result.
+     	*/
+		KMeansResult();
+
+		KMeansResult(const KMeansResult&) = delete;
+		KMeansResult& operator=(const KMeansResult&) = delete;
+
+		/**
+     	* @brief Move constructor. The source is left empty.
+     	*/
+		KMeansResult(KMeansResult&& other);
+
+		/**
+     	* @brief Move assignment. The source is left empty.
+     	*/
+		KMeansResult& operator=(KMeansResult&& other);
+
+		/**
+     	* @brief Gets the number of clusters.
+     	* @return K as an integer.
+     	*/
+		int getK(void) const;
+
+		/**
+     	* @brief Gets the x-coordinate of a cluster center.
+     	* @param clusterID The cluster ID (1..K).
+     	* @return The x-coordinate as a double.
+     	*/
+		double getCenterX(int clusterID) const;
+
+		/**
+     	* @brief Gets the y-coordinate of a cluster center.
+     	* @param clusterID The cluster ID (1..K).
+     	* @return The y-coordinate as a double.
+     	*/
+		double getCenterY(int clusterID) const;
+
+		/**
+     	* @brief Gets the cluster ID of every input point, in input order.
+     	* @return A constant reference to the label vector.
+     	*/
+		const vector<int>& getLabels(void) const;
+
+		/**
+     	* @brief Gets the number of points assigned to a cluster.
+     	* @param clusterID The cluster ID (1..K).
+     	* @return The member count.
+     	*/
+		size_t getClusterSize(int clusterID) const;
+
+		/**
+     	* @brief Gets the number of assignment/update iterations performed.
+     	* @return The iteration count.
+     	*/
+		int getIterations(void) const;
+
+		/**
+     	* @brief Gets the sum of squared distances of the points to their centers.
+     	* @return The inertia as a double.
+     	*/
+		double getInertia(void) const;
+
+		/**
+     	* @brief Checks whether the centers stopped moving before the iteration limit.
+     	* @return True if the run converged, otherwise false.
+     	*/
+		bool hasConverged(void) const;
+
+		/**
+     	* @brief Gets the wall time of the iterations (seeding and setup excluded).
+     	* @return The time in seconds.
+     	*/
+		double getElapsedSeconds(void) const;
+
+		/**
+     	* @brief Gets the time every assignment thread spent working, summed over all iterations.
+     	* @return A constant reference to the busy times in seconds, one per thread.
+     	*/
+		const vector<double>& getThreadBusySeconds(void) const;
+
+		/**
+     	* @brief Gets the number of work ranges every assignment thread stole from another, summed over all iterations.
+     	* @return A constant reference to the steal counts, one per thread.
+     	*/
+		const vector<size_t>& getThreadSteals(void) const;
+
+		/**
+     	* @brief Gets the load imbalance of the assignment threads: the longest busy time over the mean.
+     	* @return 1.0 for a perfect balance, up to the thread count when one thread did all the work.
+     	*/
+		double getLoadImbalance(void) const;
+
+		/**
+     	* @brief Gets the node index every assignment thread worked on.
+     	* @return A constant reference to the node indices, one per thread.
+     	*/
+		const vector<int>& getThreadNodes(void) const;
+
+		/**
+     	* @brief Gets the number of points every assignment thread labelled, summed over all iterations.
+     	* @return A constant reference to the point counts, one per thread.
+     	*/
+		const vector<size_t>& getThreadPoints(void) const;
+
+		/**
+     	* @brief Gets how many of getThreadPoints() lay on another node than the thread's own.
+     	* @return A constant reference to the remote point counts, one per thread.
+     	*/
+		const vector<size_t>& getThreadRemotePoints(void) const;
+
+		/**
+     	* @brief Gets the number of points placed on every node.
+     	* @return A constant reference to the point counts (a single entry without NUMA placement).
+     	*/
+		const vector<size_t>& getNodePoints(void) const;
+
+		/**
+     	* @brief Gets a number that changes with every fit() written into this result.
+     	* @return The revision; 0 for a result that was never fitted.
+     	*
+     	* Revisions are unique across all results of the process, so caches keyed on the
+     	* revision see a refit even when it reuses the label storage.
+     	*/
+		unsigned long long getRevision(void) const;
+
+	private:
+
+		/**
+     	* @brief Number of clusters.
+     	*/
+		int K;
+
+		/**
+     	* @brief Cluster center x-coordinates, indexed by clusterID - 1.
+     	*/
+		vector<double> centerX;
+
+		/**
+     	* @brief Cluster center y-coordinates, indexed by clusterID - 1.
+     	*/
+		vector<double> centerY;
+
+		/**
+     	* @brief Member count of every cluster, indexed by clusterID - 1.
+     	*/
+		vector<size_t> sizes;
+
+		/**
+     	* @brief Cluster ID of every input point.
+     	*/
+		vector<int> labels;
+
+		/**
+     	* @brief Number of iterations performed.
+     	*/
+		int iterations;
+
+		/**
+     	* @brief Sum of squared point-to-center distances.
+     	*/
+		double inertia;
+
+		/**
+     	* @brief Whether the run converged.
+     	*/
+		bool converged;
+
+		/**
+     	* @brief Wall time of the iterations in seconds.
+     	*/
+		double elapsedSeconds;
+
+		/**
+     	* @brief Busy time of every assignment thread in seconds.
+     	*/
+		vector<double> threadBusySeconds;
+
+		/**
+     	* @brief Ranges stolen by every assignment thread.
+     	*/
+		vector<size_t> threadSteals;
+
+		/**
+     	* @brief Node index of every assignment thread.
+     	*/
+		vector<int> threadNodes;
+
+		/**
+     	* @brief Points labelled by every assignment thread.
+     	*/
+		vector<size_t> threadPoints;
+
+		/**
+     	* @brief Points of another node labelled by every assignment thread.
+     	*/
+		vector<size_t> threadRemotePoints;
+
+		/**
+     	* @brief Points placed on every node.
+     	*/
+		vector<size_t> nodePoints;
+
+		/**
+     	* @brief Revision of the fit that produced the result, 0 if none.
+     	*/
+		unsigned long long revision;
+};
+
+#endif
@@ -0,0 +1,231 @@
+#include "NumaTopology.h"
+#include <algorithm>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <sched.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+/**
+ * @file NumaTopology.cpp
+ * @brief Detection of NUMA nodes and thread pinning.
+ */
+
+/**
+ * @brief Parses a Linux CPU list such as "0-3,8,10-11".
+ * @param text The list to parse.
+ * @return The CPU numbers.
+ */
+static vector<int> parseCpuList(const string& text) {
+    vector<int> cpus;
+    stringstream list(text);
+    string range;
+
+    while (getline(list, range, ',')) {
+        size_t dash = range.find('-');
+        int first = 0, last = 0;
+        try {
+            first = stoi(range.substr(0, dash));
+            last = dash == string::npos ? first : stoi(range.substr(dash + 1));
+        }
+        catch (const exception&) {
+            continue;
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+
+    return cpus;
+}
+
+/**
+ * @brief Constructor. Detects the topology of the running machine.
+ */
+NumaTopology::NumaTopology() {
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    bool haveMask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+    DIR* directory = opendir("/sys/devices/system/node");
+    if (directory != nullptr) {
+        vector<int> ids;
+        while (dirent* entry = readdir(directory)) {
+            string name = entry->d_name;
+            if (name.size() > 4 && name.compare(0, 4, "node") == 0
+                && name.find_first_not_of("0123456789", 4) == string::npos) {
+                ids.push_back(stoi(name.substr(4)));
+            }
+        }
+        closedir(directory);
+        sort(ids.begin(), ids.end());
+
+        for (int id : ids) {
+            ifstream file("/sys/devices/system/node/node" + to_string(id) + "/cpulist");
+            string text;
+            getline(file, text);
+
+            vector<int> cpus;
+            for (int cpu : parseCpuList(text)) {
+                if (!haveMask || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))) {
+                    cpus.push_back(cpu);
+                }
+            }
+            if (!cpus.empty()) {
+                nodeIDs.push_back(id);
+                nodeCpus.push_back(cpus);
+            }
+        }
+    }
+#endif
+
+    if (nodeCpus.empty()) {
+        detectFallback();
+    }
+}
+
+/**
+ * @brief Destructor for the NumaTopology class.
+ */
+NumaTopology::~NumaTopology() {}
+
+/**
+ * @brief Falls back to a single node holding every hardware thread.
+ */
+void NumaTopology::detectFallback(void) {
+    int count = max(1u, thread::hardware_concurrency());
+    vector<int> cpus;
+    for (int cpu = 0; cpu < count; ++cpu) {
+        cpus.push_back(cpu);
+    }
+    nodeIDs.assign(1, 0);
+    nodeCpus.assign(1, cpus);
+}
+
+/**
+ * @brief Gets the number of nodes with usable CPUs.
+ * @return The node count.
+ */
+int NumaTopology::getNodeCount(void) const {
+    return static_cast<int>(nodeCpus.size());
+}
+
+/**
+ * @brief Gets the CPUs of a node.
+ * @param node The node index.
+ * @return The CPU numbers.
+ */
+const vector<int>& NumaTopology::getCpus(int node) const {
+    return nodeCpus.at(node);
+}
+
+/**
+ * @brief Gets the operating system id of a node.
+ * @param node The node index.
+ * @return The node id.
+ */
+int NumaTopology::getNodeID(int node) const {
+    return nodeIDs.at(node);
+}
+
+/**
+ * @brief Pins the calling thread to one CPU.
+ * @param cpu The CPU number.
+ * @return True if the affinity was changed.
+ *
+ * Only implemented on Linux; other platforms leave scheduling to the operating system.
+ */
+bool NumaTopology::pinCurrentThread(int cpu) {
+#ifdef __linux__
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+/**
+ * @brief Allocates whole pages straight from the operating system.
+ * @param bytes The size needed.
+ * @return Page-aligned memory.
+ * @throws bad_alloc If the memory cannot be mapped.
+ *
+ * Small heap blocks share pages with other allocations and often reuse pages another
+ * thread already touched, so first touch would not decide where they live. Fresh
+ * anonymous mappings are not backed by memory until they are written.
+ */
+void* NumaTopology::allocatePages(size_t bytes) {
+    bytes = max<size_t>(bytes, 1);
+#ifdef _WIN32
+    void* memory = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (memory == nullptr) {
+        throw bad_alloc();
+    }
+#else
+    void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        throw bad_alloc();
+    }
+#endif
+    return memory;
+}
+
+/**
+ * @brief Releases memory returned by allocatePages().
+ * @param memory The memory, or nullptr.
+ * @param bytes The size passed to allocatePages().
+ */
+void NumaTopology::freePages(void* memory, size_t bytes) {
+    if (memory == nullptr) {
+        return;
+    }
+#ifdef _WIN32
+    (void)bytes;
+    VirtualFree(memory, 0, MEM_RELEASE);
+#else
+    munmap(memory, max<size_t>(bytes, 1));
+#endif
+}
+
+/**
+ * @brief Overloads the << operator to output the node layout.
+ * @param OUTPUT The output stream to write to.
+ * @param t The topology to write.
+ * @return A reference to the output stream.
+ *
+ * Outputs one line per node in the format:
+ * Node <id> : <cpu count> CPUs (<first>-<last>)
+ */
+ostream& operator<<(ostream &OUTPUT, const NumaTopology &t)
+{
+	for (int node = 0; node < t.getNodeCount(); ++node)
+	{
+		const vector<int>& cpus = t.getCpus(node);
+		OUTPUT << "Node " << t.getNodeID(node) << " : " << cpus.size() << " CPUs ("
+		<< cpus.front() << "-" << cpus.back() << ")" << endl;
+	}
+
+	return OUTPUT;
+}
@@ -0,0 +1,74 @@
+#ifndef NUMATOPOLOGY_H
+#define NUMATOPOLOGY_H
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @class NumaTopology
+ * @brief Lists the NUMA nodes of the machine and the CPUs that belong to each of them.
+ *
+ * On Linux the nodes are read from /sys/devices/system/node and restricted to the CPUs
+ * the process may run on. Elsewhere, or when nothing can be read, the machine is
+ * reported as a single node holding every hardware thread.
+ */
+class NumaTopology
+{
+	/// Overloaded << operator for printing the node layout.
+    /// @param OUTPUT The output stream to write to.
+   	/// @param t The NumaTopology object to be printed.
+    /// @return A reference to the output stream.
+	friend ostream& operator<<(ostream &OUTPUT, const NumaTopology &t);
+
+	public:
+
+		/// @brief Constructor. Detects the topology of the running machine.
+		NumaTopology();
+
+		/// @brief Destructor for the NumaTopology class.
+		~NumaTopology();
+
+		/// @brief Retrieves the number of nodes that have at least one usable CPU.
+    	/// @return The node count (at least 1).
+		int getNodeCount(void) const;
+
+		/// @brief Retrieves the CPUs of a node.
+    	/// @param node The node index (0..getNodeCount() - 1).
+    	/// @return A constant reference to the CPU numbers.
+		const vector<int>& getCpus(int node) const;
+
+		/// @brief Retrieves the operating system id of a node (as in /sys/devices/system/node/node<id>).
+    	/// @param node The node index (0..getNodeCount() - 1).
+    	/// @return The node id.
+		int getNodeID(int node) const;
+
+		/// @brief Pins the calling thread to one CPU.
+    	/// @param cpu The CPU number.
+    	/// @return True if the affinity was changed, false if pinning is unsupported or failed.
+		static bool pinCurrentThread(int cpu);
+
+		/// @brief Allocates whole, untouched pages that no other allocation shares.
+    	/// @param bytes The size needed; rounded up to whole pages.
+    	/// @return Page-aligned memory; every page is placed on the node of the thread that writes it first.
+    	/// @throws bad_alloc if the memory cannot be mapped.
+		static void* allocatePages(size_t bytes);
+
+		/// @brief Releases memory returned by allocatePages().
+    	/// @param memory The memory, or nullptr.
+    	/// @param bytes The size passed to allocatePages().
+		static void freePages(void* memory, size_t bytes);
+
+	private:
+
+		/// @brief Falls back to a single node holding every hardware thread.
+		void detectFallback(void);
+
+		/// @brief Operating system id of every node.
+		vector<int> nodeIDs;
+
+		/// @brief Usable CPUs of every node.
+		vector<vector<int> > nodeCpus;
+};
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef POINTSPAN_H
+#define POINTSPAN_H
+#include <cstddef>
+
+using namespace std;
+
+/// @class PointSpan
+/// @brief Non-owning view over two parallel coordinate arrays (x[i], y[i]).
+///
+/// The caller keeps the arrays alive for as long as the span is used; nothing is copied.
+/// The accessors are defined inline because they sit in the innermost distance loop.
+class PointSpan
+{
+	public:
+
+		/// @brief Constructs an empty span.
+		PointSpan()
+		: xs(nullptr), ys(nullptr), count(0)
+		{
+		}
+
+		/// @brief Constructs a span over existing coordinate arrays.
+    	/// @param X Pointer to the first x-coordinate.
+    	/// @param Y Pointer to the first y-coordinate.
+    	/// @param n The number of points in both arrays.
+		PointSpan(const double* X, const double* Y, size_t n)
+		: xs(X), ys(Y), count(n)
+		{
+		}
+
+		/// @brief Retrieves the number of points in the span.
+    	/// @return The number of points.
+		size_t size(void) const { return count; }
+
+		/// @brief Checks whether the span contains no points.
+    	/// @return True if the span is empty, otherwise false.
+		bool empty(void) const { return count == 0; }
+
+		/// @brief Retrieves the x-coordinate of a point.
+    	/// @param i The index of the point.
+    	/// @return The x-coordinate as a double.
+		double x(size_t i) const { return xs[i]; }
+
+		/// @brief Retrieves the y-coordinate of a point.
+    	/// @param i The index of the point.
+    	/// @return The y-coordinate as a double.
+		double y(size_t i) const { return ys[i]; }
+
+		/// @brief Retrieves the underlying x-coordinate array.
+		const double* xData(void) const { return xs; }
+
+		/// @brief Retrieves the underlying y-coordinate array.
+		const double* yData(void) const { return ys; }
+
+		/// @brief Creates a span over a contiguous sub-range of this span.
+    	/// @param first The index of the first point of the sub-range.
+    	/// @param n The number of points in the sub-range.
+    	/// @return A span that shares storage with this one.
+		PointSpan subspan(size_t first, size_t n) const { return PointSpan(xs + first, ys + first, n); }
+
+	private:
+
+		/// @brief The x-coordinates of the points.
+		const double* xs;
+
+		/// @brief The y-coordinates of the points.
+		const double* ys;
+
+		/// @brief The number of points.
+		size_t count;
+};
+
+#endif
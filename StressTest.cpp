@@ -0,0 +1,278 @@
+#include "StressTest.h"
+#include "KMeans.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * @file StressTest.cpp
+ * @brief Implementation of the randomized engine and parser self-checks.
+ */
+
+/**
+ * @brief Constructs a stress test.
+ * @param seed Seed from which every case is derived.
+ */
+StressTest::StressTest(unsigned int seed) : seed(seed) {}
+
+/**
+ * @brief Fills xs and ys with n random points of a random layout.
+ * @param generator The random generator of the case.
+ * @param n The number of points.
+ * @param xs Receives the x-coordinates.
+ * @param ys Receives the y-coordinates.
+ * @return Name of the layout.
+ *
+ * The grid and repeated-point layouts produce distance ties and empty clusters,
+ * the wide layout large magnitudes.
+ */
+string StressTest::generatePoints(mt19937& generator, size_t n, vector<double>& xs, vector<double>& ys) {
+    xs.resize(n);
+    ys.resize(n);
+    int layout = uniform_int_distribution<int>(0, 4)(generator);
+
+    if (layout == 0) {
+        uniform_real_distribution<double> position(0.0, 100.0);
+        for (size_t i = 0; i < n; ++i) {
+            xs[i] = position(generator);
+            ys[i] = position(generator);
+        }
+        return "uniform";
+    }
+    if (layout == 1) {
+        int blobs = uniform_int_distribution<int>(1, 8)(generator);
+        uniform_real_distribution<double> position(0.0, 100.0);
+        normal_distribution<double> spread(0.0, 3.0);
+        vector<double> blobX(blobs), blobY(blobs);
+        for (int b = 0; b < blobs; ++b) {
+            blobX[b] = position(generator);
+            blobY[b] = position(generator);
+        }
+        uniform_int_distribution<int> blob(0, blobs - 1);
+        for (size_t i = 0; i < n; ++i) {
+            int b = blob(generator);
+            xs[i] = blobX[b] + spread(generator);
+            ys[i] = blobY[b] + spread(generator);
+        }
+        return "blobs";
+    }
+    if (layout == 2) {
+        uniform_int_distribution<int> cell(0, 4);
+        for (size_t i = 0; i < n; ++i) {
+            xs[i] = cell(generator);
+            ys[i] = cell(generator);
+        }
+        return "grid";
+    }
+    if (layout == 3) {
+        double x = uniform_real_distribution<double>(-10.0, 10.0)(generator);
+        double y = uniform_real_distribution<double>(-10.0, 10.0)(generator);
+        fill(xs.begin(), xs.end(), x);
+        fill(ys.begin(), ys.end(), y);
+        return "repeated";
+    }
+
+    uniform_real_distribution<double> position(-1e6, 1e6);
+    for (size_t i = 0; i < n; ++i) {
+        xs[i] = position(generator);
+        ys[i] = position(generator);
+    }
+    return "wide";
+}
+
+/**
+ * @brief Runs randomized fits with the invariant checks on.
+ * @param cases The number of random problems.
+ * @param OUTPUT The stream to print to.
+ * @return True if every case passed.
+ */
+bool StressTest::checkEngine(int cases, ostream& OUTPUT) {
+    int failures = 0;
+
+    for (int c = 0; c < cases; ++c) {
+        seed_seq sequence = { seed, static_cast<unsigned int>(c), 0u };
+        mt19937 generator(sequence);
+
+        size_t n = uniform_int_distribution<size_t>(1, c % 4 == 0 ? 20000 : 2000)(generator);
+        int k = uniform_int_distribution<int>(1, static_cast<int>(min<size_t>(n, 24)))(generator);
+        vector<double> xs, ys;
+        string layout = generatePoints(generator, n, xs, ys);
+        PointSpan points(xs.data(), ys.data(), n);
+
+        KMeansOptions options;
+        options.seeding = static_cast<SeedingMethod>(uniform_int_distribution<int>(0, 2)(generator));
+        options.randomSeed = generator();
+        options.threads = uniform_int_distribution<int>(1, 4)(generator);
+        options.reduction = generator() % 2 == 0 ? ReductionMode::FAST : ReductionMode::DETERMINISTIC;
+        options.numaPlacement = generator() % 4 == 0;
+        options.maxIterations = generator() % 4 == 0 ? uniform_int_distribution<int>(1, 5)(generator) : 0;
+        options.checkInvariants = true;
+
+        ostringstream name;
+        name << "case " << c << " (n=" << n << ", k=" << k << ", " << layout
+             << ", threads=" << options.threads
+             << (options.reduction == ReductionMode::DETERMINISTIC ? ", deterministic" : ", fast")
+             << (options.numaPlacement ? ", numa" : "") << ")";
+
+        try {
+            KMeansEngine engine(options);
+            KMeansResult result;
+            engine.fit(points, k, result);
+
+            if (options.reduction == ReductionMode::DETERMINISTIC) {
+                KMeansOptions referenceOptions = options;
+                referenceOptions.threads = 1;
+                referenceOptions.numaPlacement = false;
+                KMeansEngine reference(referenceOptions);
+                KMeansResult expected = reference.fit(points, k);
+                for (int id = 1; id <= k; ++id) {
+                    if (result.getCenterX(id) != expected.getCenterX(id)
+                        || result.getCenterY(id) != expected.getCenterY(id)) {
+                        throw logic_error("deterministic centers differ from the single-thread run");
+                    }
+                }
+                if (result.getLabels() != expected.getLabels()) {
+                    throw logic_error("deterministic labels differ from the single-thread run");
+                }
+            }
+
+            // Refit a prefix with another K on the same engine: the buffers are reused.
+            size_t prefix = uniform_int_distribution<size_t>(1, n)(generator);
+            int prefixK = uniform_int_distribution<int>(1, static_cast<int>(min<size_t>(prefix, 24)))(generator);
+            engine.fit(PointSpan(xs.data(), ys.data(), prefix), prefixK, result);
+
+            bool rejected = false;
+            try {
+                engine.fit(PointSpan(xs.data(), ys.data(), prefix), static_cast<int>(prefix) + 1, result);
+            }
+            catch (const invalid_argument&) {
+                rejected = true;
+            }
+            if (!rejected) {
+                throw logic_error("K larger than the number of points was accepted");
+            }
+        }
+        catch (const exception& e) {
+            OUTPUT << name.str() << ": " << e.what() << "\n";
+            ++failures;
+        }
+    }
+
+    OUTPUT << "Engine invariants: " << cases - failures << " of " << cases << " cases passed" << endl;
+    return failures == 0;
+}
+
+/**
+ * @brief Feeds mutated input files through the KMeans stream constructor.
+ * @param cases The number of mutated inputs.
+ * @param OUTPUT The stream to print to.
+ * @return True if every case passed.
+ */
+bool StressTest::fuzzLoader(int cases, ostream& OUTPUT) {
+    static const string alphabet = "0123456789 .-+eE\t\r\nxna,";
+    int failures = 0, rejected = 0;
+
+    for (int c = 0; c < cases; ++c) {
+        seed_seq sequence = { seed, static_cast<unsigned int>(c), 1u };
+        mt19937 generator(sequence);
+
+        // A valid file: "index x y" lines, sometimes with CRLF endings or blank lines, and
+        // sometimes with coordinates up to the loader's limit, where sums of squares are largest.
+        ostringstream file;
+        int lines = uniform_int_distribution<int>(0, 30)(generator);
+        bool crlf = generator() % 2 == 0;
+        double scale = generator() % 4 == 0 ? KMeans::MAX_COORDINATE : 100.0;
+        uniform_real_distribution<double> position(-scale, scale);
+        // Sometimes one x-coordinate beyond the limit (up to 1e308), which must be rejected.
+        int outOfRange = lines > 0 && generator() % 8 == 0 ? uniform_int_distribution<int>(0, lines - 1)(generator) : -1;
+        for (int i = 0; i < lines; ++i) {
+            if (generator() % 10 == 0) {
+                file << (crlf ? "\r\n" : "\n");
+            }
+            double x = position(generator);
+            if (i == outOfRange) {
+                x = (generator() % 2 == 0 ? 1.0 : -1.0) * pow(10.0, uniform_real_distribution<double>(101.0, 308.0)(generator));
+            }
+            file << i << " " << x << " " << position(generator) << (crlf ? "\r\n" : "\n");
+        }
+        string text = file.str();
+
+        // Random edits: delete, insert or replace a character, or cut the file short.
+        // An unedited file is valid and must load completely.
+        int edits = uniform_int_distribution<int>(0, 3)(generator);
+        bool edited = false;
+        for (int e = 0; e < edits && !text.empty(); ++e) {
+            size_t at = uniform_int_distribution<size_t>(0, text.size() - 1)(generator);
+            char ch = alphabet[uniform_int_distribution<size_t>(0, alphabet.size() - 1)(generator)];
+            switch (generator() % 4) {
+                case 0: text.erase(at, 1); break;
+                case 1: text.insert(at, 1, ch); break;
+                case 2: text[at] = ch; break;
+                default: text.resize(at); break;
+            }
+            edited = true;
+        }
+
+        size_t dataLines = 0;
+        istringstream scan(text);
+        string line;
+        while (getline(scan, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (line.find_first_not_of(" \t") != string::npos) {
+                ++dataLines;
+            }
+        }
+
+        int k = uniform_int_distribution<int>(1, 4)(generator);
+        size_t expected = edited ? dataLines : static_cast<size_t>(lines);
+        bool mustReject = !edited && outOfRange >= 0;
+        string failure;
+        try {
+            KMeansOptions options;
+            options.checkInvariants = true;
+            istringstream input(text);
+            KMeans kmeans(input, k, options);
+            if (kmeans.getSamples().size() != expected) {
+                throw logic_error("loaded " + to_string(kmeans.getSamples().size()) + " samples from "
+                                  + to_string(expected) + " data lines");
+            }
+            if (mustReject) {
+                throw logic_error("coordinate beyond MAX_COORDINATE accepted on line " + to_string(outOfRange + 1));
+            }
+            kmeans.run();
+        }
+        catch (const runtime_error& e) {
+            // A malformed line can only come from an edit or the out-of-range coordinate.
+            if (edited || mustReject) {
+                ++rejected;
+            } else {
+                failure = string("valid file rejected: ") + e.what();
+            }
+        }
+        catch (const invalid_argument& e) {
+            // Only a file with fewer samples than K may be refused for its size.
+            if (expected < static_cast<size_t>(k)) {
+                ++rejected;
+            } else {
+                failure = string("rejected with ") + to_string(expected) + " samples and K = " + to_string(k)
+                        + ": " + e.what();
+            }
+        }
+        catch (const exception& e) {
+            failure = e.what();
+        }
+        if (!failure.empty()) {
+            OUTPUT << "loader case " << c << (edited ? "" : " (unedited)") << ": " << failure << "\n";
+            ++failures;
+        }
+    }
+
+    OUTPUT << "Loader fuzzing: " << cases - failures << " of " << cases << " inputs handled ("
+           << rejected << " rejected)" << endl;
+    return failures == 0;
+}
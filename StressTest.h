@@ -0,0 +1,76 @@
+#ifndef STRESSTEST_H
+#define STRESSTEST_H
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "KMeansEngine.h"
+
+using namespace std;
+
+/**
+ * @class StressTest
+ * @brief Randomized self-checks of the engine invariants and of the input parser.
+ *
+ * Every case is derived from the seed and the case number, so a failure printed as
+ * "case 17" is reproduced by running the same seed again. Build with
+ * -fsanitize=address,undefined to turn memory errors and undefined behaviour on the
+ * way into failures as well.
+ */
+class StressTest
+{
+	public:
+
+		/**
+     	* @brief Constructs a stress test.
+     	* @param seed Seed from which every case is derived.
+     	*/
+		explicit StressTest(unsigned int seed);
+
+		/**
+     	* @brief Runs randomized fits with KMeansOptions::checkInvariants set.
+     	* @param cases The number of random problems.
+     	* @param OUTPUT The stream failures and the summary are printed to.
+     	* @return True if every case passed.
+     	*
+     	* Varies N, K, the point layout (uniform, blobs, duplicate-heavy grids, one repeated
+     	* point), seeding, thread count, reduction mode and NUMA placement. Besides the
+     	* per-iteration invariants it checks that K > N is rejected and that DETERMINISTIC
+     	* results do not depend on the thread count.
+     	*/
+		bool checkEngine(int cases, ostream& OUTPUT);
+
+		/**
+     	* @brief Feeds mutated input files through the KMeans stream constructor.
+     	* @param cases The number of mutated inputs.
+     	* @param OUTPUT The stream failures and the summary are printed to.
+     	* @return True if every case passed.
+     	*
+     	* Each input is a valid file (LF or CRLF, with blank lines, coordinates up to
+     	* KMeans::MAX_COORDINATE) with up to three random byte edits. The parser must load
+     	* exactly one sample per non-blank line, and may only reject an edited file with
+     	* runtime_error, or a file with fewer samples than K with invalid_argument. Some files
+     	* get one coordinate beyond the limit and must be rejected. Loaded inputs are then
+     	* clustered with the invariant checks on.
+     	*/
+		bool fuzzLoader(int cases, ostream& OUTPUT);
+
+	private:
+
+		/**
+     	* @brief Fills xs and ys with n random points of a random layout.
+     	* @param generator The random generator of the case.
+     	* @param n The number of points.
+     	* @param xs Receives the x-coordinates.
+     	* @param ys Receives the y-coordinates.
+     	* @return Name of the layout, for failure messages.
+     	*/
+		static string generatePoints(mt19937& generator, size_t n, vector<double>& xs, vector<double>& ys);
+
+		/**
+     	* @brief Seed from which every case is derived.
+     	*/
+		unsigned int seed;
+};
+
+#endif
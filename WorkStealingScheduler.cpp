@@ -0,0 +1,347 @@
+#include "WorkStealingScheduler.h"
+#include "NumaTopology.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * @file WorkStealingScheduler.cpp
+ * @brief Implementation of the work-stealing thread pool.
+ */
+
+/**
+ * @brief Starts one worker thread per CPU entry.
+ * @param cpus The CPU of every worker, or -1 for unpinned.
+ * @param nodes The NUMA node index of every worker.
+ * @throws invalid_argument If the vectors are empty or differ in length.
+ */
+WorkStealingScheduler::WorkStealingScheduler(const vector<int>& cpus, const vector<int>& nodes)
+    : generation(0), busyWorkers(0), stopping(false), rangeTask(nullptr), workerTask(nullptr),
+      grain(1), remaining(0), idleWorkers(0), failed(false) {
+    if (cpus.empty() || cpus.size() != nodes.size()) {
+        throw invalid_argument("Every worker needs exactly one CPU and one node entry.");
+    }
+
+    for (size_t w = 0; w < cpus.size(); ++w) {
+        unique_ptr<Worker> worker(new Worker());
+        worker->cpu = cpus[w];
+        worker->node = nodes[w];
+        worker->busySeconds = 0.0;
+        worker->steals = 0;
+        workers.push_back(move(worker));
+    }
+    for (size_t w = 0; w < cpus.size(); ++w) {
+        threads.emplace_back(&WorkStealingScheduler::workerLoop, this, static_cast<int>(w));
+    }
+}
+
+/**
+ * @brief Destructor. Stops and joins the worker threads.
+ */
+WorkStealingScheduler::~WorkStealingScheduler() {
+    {
+        lock_guard<mutex> guard(jobLock);
+        stopping = true;
+    }
+    jobReady.notify_all();
+
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+/**
+ * @brief Gets the number of worker threads.
+ * @return The worker count.
+ */
+int WorkStealingScheduler::getWorkerCount(void) const {
+    return static_cast<int>(workers.size());
+}
+
+/**
+ * @brief Runs task over [0, count) starting from equal contiguous shares.
+ * @param count The number of indices.
+ * @param grain The largest piece handed to task at once.
+ * @param task The work to run.
+ */
+void WorkStealingScheduler::parallelFor(size_t count, size_t grain, const RangeTask& task) {
+    vector<size_t> bounds(workers.size() + 1);
+    for (size_t w = 0; w <= workers.size(); ++w) {
+        bounds[w] = count * w / workers.size();
+    }
+    parallelFor(bounds, grain, task);
+}
+
+/**
+ * @brief Runs task over [bounds.front(), bounds.back()) starting from the given shares.
+ * @param bounds One boundary more than there are workers.
+ * @param grain The largest piece handed to task at once.
+ * @param task The work to run.
+ * @throws invalid_argument If bounds has the wrong length.
+ */
+void WorkStealingScheduler::parallelFor(const vector<size_t>& bounds, size_t grain, const RangeTask& task) {
+    if (bounds.size() != workers.size() + 1) {
+        throw invalid_argument("parallelFor needs one boundary more than there are workers.");
+    }
+
+    // The job is published under jobLock in runJob(); the workers are all idle here.
+    for (size_t w = 0; w < workers.size(); ++w) {
+        lock_guard<mutex> guard(workers[w]->lock);
+        workers[w]->tasks.clear();
+        if (bounds[w] < bounds[w + 1]) {
+            Range range = { bounds[w], bounds[w + 1] };
+            workers[w]->tasks.push_back(range);
+        }
+    }
+
+    this->grain = max<size_t>(1, grain);
+    remaining = bounds.back() - bounds.front();
+    rangeTask = &task;
+    workerTask = nullptr;
+    runJob();
+}
+
+/**
+ * @brief Runs task once on every worker thread.
+ * @param task The work to run.
+ */
+void WorkStealingScheduler::runOnEachWorker(const WorkerTask& task) {
+    rangeTask = nullptr;
+    workerTask = &task;
+    runJob();
+}
+
+/**
+ * @brief Publishes the current job and waits for all workers to finish it.
+ * @throws Any exception a task threw.
+ */
+void WorkStealingScheduler::runJob(void) {
+    unique_lock<mutex> guard(jobLock);
+    failure = nullptr;
+    failed = false;
+    busyWorkers = static_cast<int>(workers.size());
+    ++generation;
+    jobReady.notify_all();
+    jobDone.wait(guard, [this]() { return busyWorkers == 0; });
+
+    rangeTask = nullptr;
+    workerTask = nullptr;
+    if (failure) {
+        exception_ptr error = failure;
+        failure = nullptr;
+        rethrow_exception(error);
+    }
+}
+
+/**
+ * @brief Main loop of a worker thread.
+ * @param worker The worker index.
+ *
+ * The thread pins itself once, then sleeps until a job is published.
+ */
+void WorkStealingScheduler::workerLoop(int worker) {
+    if (workers[worker]->cpu >= 0) {
+        NumaTopology::pinCurrentThread(workers[worker]->cpu);
+    }
+
+    size_t seen = 0;
+    while (true) {
+        {
+            unique_lock<mutex> guard(jobLock);
+            jobReady.wait(guard, [this, seen]() { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+
+        try {
+            if (workerTask != nullptr) {
+                (*workerTask)(worker);
+            } else {
+                runRanges(worker);
+            }
+        }
+        catch (...) {
+            recordFailure();
+        }
+
+        lock_guard<mutex> guard(jobLock);
+        if (--busyWorkers == 0) {
+            jobDone.notify_one();
+        }
+    }
+}
+
+/**
+ * @brief Runs the current range job on one worker.
+ * @param worker The worker index.
+ *
+ * The range is run front to back in pieces of at most the grain. Before each piece
+ * the worker halves what is left, pushing the upper half onto its own deque, if some
+ * worker is idle and nothing is queued here for it to steal (lazy splitting); without
+ * demand a range is never split. The worker leaves only when every index of the job
+ * has run, so a stolen half can still be split and re-stolen. After a task has thrown,
+ * the remaining ranges are drained without running them.
+ */
+void WorkStealingScheduler::runRanges(int worker) {
+    Worker& self = *workers[worker];
+    Range range;
+    int misses = 0;
+    bool idle = false;
+
+    while (remaining.load() > 0) {
+        if (!popLocal(worker, range) && !steal(worker, range)) {
+            if (!idle) {
+                idle = true;
+                ++idleWorkers;
+            }
+            // Back off once the last pieces are running, so idle workers do not
+            // take the CPU from busy ones when there are more threads than cores.
+            if (++misses < 64) {
+                this_thread::yield();
+            } else {
+                this_thread::sleep_for(chrono::microseconds(50));
+            }
+            continue;
+        }
+        if (idle) {
+            idle = false;
+            --idleWorkers;
+        }
+        misses = 0;
+
+        while (range.begin < range.end) {
+            if (range.end - range.begin > grain && idleWorkers.load() > 0 && isQueueEmpty(worker)) {
+                size_t middle = range.begin + (range.end - range.begin) / 2;
+                Range upper = { middle, range.end };
+                {
+                    lock_guard<mutex> guard(self.lock);
+                    self.tasks.push_back(upper);
+                }
+                range.end = middle;
+            }
+
+            size_t end = range.begin + min(grain, range.end - range.begin);
+            if (!failed) {
+                auto start = chrono::steady_clock::now();
+                try {
+                    (*rangeTask)(range.begin, end, worker);
+                }
+                catch (...) {
+                    recordFailure();
+                }
+                self.busySeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            }
+            remaining -= end - range.begin;
+            range.begin = end;
+        }
+    }
+
+    if (idle) {
+        --idleWorkers;
+    }
+}
+
+/**
+ * @brief Records the exception being handled as the failure of the current job.
+ *
+ * Must be called from a catch block. Only the first failure is kept.
+ */
+void WorkStealingScheduler::recordFailure(void) {
+    lock_guard<mutex> guard(jobLock);
+    if (!failure) {
+        failure = current_exception();
+        failed = true;
+    }
+}
+
+/**
+ * @brief Checks whether a worker has no ranges queued.
+ * @param worker The worker index.
+ * @return True if the deque is empty.
+ */
+bool WorkStealingScheduler::isQueueEmpty(int worker) {
+    Worker& self = *workers[worker];
+    lock_guard<mutex> guard(self.lock);
+    return self.tasks.empty();
+}
+
+/**
+ * @brief Takes the newest range of the worker's own deque.
+ * @param worker The worker index.
+ * @param range Receives the range.
+ * @return True if a range was taken.
+ */
+bool WorkStealingScheduler::popLocal(int worker, Range& range) {
+    Worker& self = *workers[worker];
+    lock_guard<mutex> guard(self.lock);
+    if (self.tasks.empty()) {
+        return false;
+    }
+    range = self.tasks.back();
+    self.tasks.pop_back();
+    return true;
+}
+
+/**
+ * @brief Takes the oldest range of another worker.
+ * @param worker The index of the stealing worker.
+ * @param range Receives the range.
+ * @return True if a range was stolen.
+ *
+ * Two passes: first over workers of the same node, then over all others,
+ * each starting after the thief so that thieves spread over different victims.
+ */
+bool WorkStealingScheduler::steal(int worker, Range& range) {
+    const int count = static_cast<int>(workers.size());
+    const int node = workers[worker]->node;
+
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int offset = 1; offset < count; ++offset) {
+            Worker& victim = *workers[(worker + offset) % count];
+            if ((victim.node == node) != (pass == 0)) {
+                continue;
+            }
+
+            lock_guard<mutex> guard(victim.lock);
+            if (!victim.tasks.empty()) {
+                range = victim.tasks.front();
+                victim.tasks.pop_front();
+                ++workers[worker]->steals;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Resets the busy times and steal counts.
+ */
+void WorkStealingScheduler::resetStats(void) {
+    for (auto& worker : workers) {
+        worker->busySeconds = 0.0;
+        worker->steals = 0;
+    }
+}
+
+/**
+ * @brief Gets the busy time of a worker.
+ * @param worker The worker index.
+ * @return The busy time in seconds.
+ */
+double WorkStealingScheduler::getBusySeconds(int worker) const {
+    return workers.at(worker)->busySeconds;
+}
+
+/**
+ * @brief Gets the steal count of a worker.
+ * @param worker The worker index.
+ * @return The number of stolen ranges.
+ */
+size_t WorkStealingScheduler::getSteals(int worker) const {
+    return workers.at(worker)->steals;
+}
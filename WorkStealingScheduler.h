@@ -0,0 +1,256 @@
+#ifndef WORKSTEALINGSCHEDULER_H
+#define WORKSTEALINGSCHEDULER_H
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @class WorkStealingScheduler
+ * @brief Persistent worker threads that share index ranges through per-thread deques.
+ *
+ * parallelFor() hands every worker an initial range. A worker runs its range front to
+ * back, at most grain indices per call of the task, and splits it lazily: only when
+ * another worker is looking for work and the worker's own deque is empty does it push
+ * the upper half of what is left onto its deque. A worker whose deque is empty steals
+ * the oldest (and therefore largest) range from the front of another worker's deque,
+ * trying workers of its own NUMA node first. Chunk sizes thus adapt to the load: an
+ * even workload runs as one range per worker with a few splits at the very end, a
+ * skewed one is split further where threads run dry.
+ */
+class WorkStealingScheduler
+{
+	public:
+
+		/**
+     	* @brief Work on the index range [begin, end), run by the given worker.
+     	*/
+		typedef function<void(size_t begin, size_t end, int worker)> RangeTask;
+
+		/**
+     	* @brief Work run exactly once by every worker.
+     	*/
+		typedef function<void(int worker)> WorkerTask;
+
+		/**
+     	* @brief Starts one thread per entry of cpus.
+     	* @param cpus The CPU every worker pins itself to, or -1 to leave it unpinned.
+     	* @param nodes The NUMA node index of every worker; used to prefer local victims when stealing.
+     	* @throws invalid_argument if the vectors are empty or differ in length.
+     	*/
+		WorkStealingScheduler(const vector<int>& cpus, const vector<int>& nodes);
+
+		/**
+     	* @brief Destructor. Stops and joins the worker threads.
+     	*/
+		~WorkStealingScheduler();
+
+		WorkStealingScheduler(const WorkStealingScheduler&) = delete;
+		WorkStealingScheduler& operator=(const WorkStealingScheduler&) = delete;
+
+		/**
+     	* @brief Gets the number of worker threads.
+     	* @return The worker count.
+     	*/
+		int getWorkerCount(void) const;
+
+		/**
+     	* @brief Runs task over [0, count), each worker starting on an equal contiguous share.
+     	* @param count The number of indices.
+     	* @param grain The largest piece handed to task at once (at least 1); workers check for idle workers between pieces, and never split a range below it.
+     	* @param task The work to run.
+     	* @throws Any exception thrown by task, after all workers have stopped.
+     	*/
+		void parallelFor(size_t count, size_t grain, const RangeTask& task);
+
+		/**
+     	* @brief Runs task over [bounds.front(), bounds.back()), worker w starting on [bounds[w], bounds[w + 1]).
+     	* @param bounds getWorkerCount() + 1 non-decreasing boundaries.
+     	* @param grain The largest piece handed to task at once (at least 1); see parallelFor(size_t, size_t, const RangeTask&).
+     	* @param task The work to run.
+     	* @throws invalid_argument if bounds has the wrong length.
+     	* @throws Any exception thrown by task, after all workers have stopped.
+     	*/
+		void parallelFor(const vector<size_t>& bounds, size_t grain, const RangeTask& task);
+
+		/**
+     	* @brief Runs task once on every worker thread.
+     	* @param task The work to run.
+     	* @throws Any exception thrown by task, after all workers have stopped.
+     	*/
+		void runOnEachWorker(const WorkerTask& task);
+
+		/**
+     	* @brief Resets the busy times and steal counts.
+     	*/
+		void resetStats(void);
+
+		/**
+     	* @brief Gets the time a worker spent inside range tasks since the last resetStats().
+     	* @param worker The worker index.
+     	* @return The busy time in seconds.
+     	*/
+		double getBusySeconds(int worker) const;
+
+		/**
+     	* @brief Gets the number of ranges a worker stole since the last resetStats().
+     	* @param worker The worker index.
+     	* @return The steal count.
+     	*/
+		size_t getSteals(int worker) const;
+
+	private:
+
+		/**
+     	* @struct Range
+     	* @brief A half-open index range.
+     	*/
+		struct Range
+		{
+			size_t begin;	///< First index.
+			size_t end;		///< One past the last index.
+		};
+
+		/**
+     	* @struct Worker
+     	* @brief Deque and statistics of one worker thread.
+     	*/
+		struct Worker
+		{
+			mutex lock;				///< Guards tasks.
+			deque<Range> tasks;		///< Ranges waiting to run; the owner uses the back, thieves the front.
+			int cpu;				///< CPU to pin to, or -1.
+			int node;				///< NUMA node index.
+			double busySeconds;		///< Time spent in range tasks.
+			size_t steals;			///< Ranges stolen from other workers.
+		};
+
+		/**
+     	* @brief Main loop of a worker thread: wait for a job, run it, report completion.
+     	* @param worker The worker index.
+     	*/
+		void workerLoop(int worker);
+
+		/**
+     	* @brief Runs the current range job on one worker until no work is left anywhere.
+     	* @param worker The worker index.
+     	*/
+		void runRanges(int worker);
+
+		/**
+     	* @brief Checks whether a worker has no ranges queued.
+     	* @param worker The worker index.
+     	* @return True if the worker's deque is empty.
+     	*/
+		bool isQueueEmpty(int worker);
+
+		/**
+     	* @brief Takes the newest range of the worker's own deque.
+     	* @param worker The worker index.
+     	* @param range Receives the range.
+     	* @return True if a range was taken.
+     	*/
+		bool popLocal(int worker, Range& range);
+
+		/**
+     	* @brief Takes the oldest range of another worker, same-node workers first.
+     	* @param worker The index of the stealing worker.
+     	* @param range Receives the range.
+     	* @return True if a range was stolen.
+     	*/
+		bool steal(int worker, Range& range);
+
+		/**
+     	* @brief Publishes the current job to all workers and waits until they are done.
+     	*/
+		void runJob(void);
+
+		/**
+     	* @brief Records the exception being handled as the failure of the current job, unless one is recorded already.
+     	*/
+		void recordFailure(void);
+
+		/**
+     	* @brief Per-worker state; pointers keep the mutexes at fixed addresses.
+     	*/
+		vector<unique_ptr<Worker> > workers;
+
+		/**
+     	* @brief The worker threads.
+     	*/
+		vector<thread> threads;
+
+		/**
+     	* @brief Guards the job fields below.
+     	*/
+		mutex jobLock;
+
+		/**
+     	* @brief Signalled when a new job is published or the scheduler stops.
+     	*/
+		condition_variable jobReady;
+
+		/**
+     	* @brief Signalled when the last worker finishes a job.
+     	*/
+		condition_variable jobDone;
+
+		/**
+     	* @brief Incremented for every job; workers wait for it to change.
+     	*/
+		size_t generation;
+
+		/**
+     	* @brief Workers that have not finished the current job.
+     	*/
+		int busyWorkers;
+
+		/**
+     	* @brief Set by the destructor to end the worker loops.
+     	*/
+		bool stopping;
+
+		/**
+     	* @brief The range task of the current job, or nullptr.
+     	*/
+		const RangeTask* rangeTask;
+
+		/**
+     	* @brief The per-worker task of the current job, or nullptr.
+     	*/
+		const WorkerTask* workerTask;
+
+		/**
+     	* @brief Largest piece of the current range job.
+     	*/
+		size_t grain;
+
+		/**
+     	* @brief Indices of the current range job that have not run yet.
+     	*/
+		atomic<size_t> remaining;
+
+		/**
+     	* @brief Workers of the current range job that found no range to run; busy workers split for them.
+     	*/
+		atomic<int> idleWorkers;
+
+		/**
+     	* @brief First exception thrown by a task of the current job.
+     	*/
+		exception_ptr failure;
+
+		/**
+     	* @brief Set together with failure, so workers can skip the remaining ranges without locking.
+     	*/
+		atomic<bool> failed;
+};
+
+#endif
@@ -0,0 +1,77 @@
+#include "KMeans.h"
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+/**
+ * @file fuzz_loader.cpp
+ * @brief libFuzzer target for the input parser and the clustering that follows it.
+ *
+ * Not part of the Dev-C++ project; it has no main() and is built with clang:
+ *     clang++ -std=gnu++11 -g -O1 -fsanitize=fuzzer,address,undefined -pthread fuzz_loader.cpp
+ *         Sample.cpp Cluster.cpp KMeans.cpp KMeansEngine.cpp KMeansResult.cpp
+ *         NumaTopology.cpp WorkStealingScheduler.cpp -o fuzz_loader
+ *
+ * The first byte picks K (1..4), the rest is the input file. Rejecting the file with
+ * runtime_error (malformed line) or invalid_argument (fewer samples than K) is a valid
+ * outcome; anything else, including a logic_error from the invariant checks, escapes
+ * and is reported by libFuzzer as a crash.
+ */
+
+/**
+ * @brief Counts the lines of a file that hold more than blanks, ignoring CR before LF.
+ * @param text The file contents.
+ * @return The number of data lines.
+ */
+static size_t countDataLines(const string& text) {
+    size_t lines = 0;
+    istringstream scan(text);
+    string line;
+    while (getline(scan, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.find_first_not_of(" \t") != string::npos) {
+            ++lines;
+        }
+    }
+    return lines;
+}
+
+/**
+ * @brief Entry point called by libFuzzer for every generated input.
+ * @param data The input bytes.
+ * @param size The number of bytes.
+ * @return Always 0.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+
+    int k = data[0] % 4 + 1;
+    string text(reinterpret_cast<const char*>(data) + 1, size - 1);
+
+    KMeansOptions options;
+    options.checkInvariants = true;
+    try {
+        istringstream input(text);
+        KMeans kmeans(input, k, options);
+        if (kmeans.getSamples().size() != countDataLines(text)) {
+            throw logic_error("loaded " + to_string(kmeans.getSamples().size()) + " samples from "
+                              + to_string(countDataLines(text)) + " data lines");
+        }
+        kmeans.run();
+    }
+    catch (const runtime_error&) {
+        // Malformed line.
+    }
+    catch (const invalid_argument&) {
+        // Fewer samples than K.
+    }
+    return 0;
+}
@@ -1,83 +1,336 @@
 /**
  * @file main.cpp
  * @brief Entry point for executing the K-Means clustering algorithm and visualizing results.
- * 
+ *
  * This program performs K-Means clustering on input data, saves the results to files, and
- * visualizes the clustering output using Gnuplot.
- * 
+ * visualizes the clustering output using Gnuplot. Every setting can be changed from the
+ * command line; run with --help for the list of flags.
+ *
  * @author [Doukan Avc]
  * @date [22.12.2024]
  */
 
 #include <iostream>
 #include <fstream>
-#include <cstdlib> // for system() 
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
 #include "KMeans.h"
+#include "GnuplotRenderer.h"
+#include "Benchmark.h"
+#include "StressTest.h"
 
 using namespace std;
 
 /**
- * @brief Creates a Gnuplot script to visualize clustering results and executes it.
- * 
- * @param dataFile The name of the data file containing clustering results in the format:
- *                 `x-coordinate y-coordinate clusterID`
- * 
- * The function generates a Gnuplot script and executes it to display the clustering results
- * as a scatter plot. Each cluster is visualized with a unique color.
+ * @struct CommandLine
+ * @brief Settings collected from the command line. The defaults reproduce the original lab run.
  */
- 
-void plotWithGnuplot(const string& dataFile) {
-    ofstream gnuplotScript("plot_script.gnu");
-    if (!gnuplotScript) {
-        cerr << "Gnuplot script dosyas oluturulamad!" << endl;
-        return;
+struct CommandLine
+{
+	string inputFile = "40.txt";     		///< Name of the input data file
+	string outputFile = "output.txt";		///< Name of the file to save detailed clustering results ("none" to skip)
+	string plotFile = "plotFile.txt"; 		///< Name of the file to save results for Gnuplot ("none" to skip)
+	string csvFile;							///< Name of the CSV file to save results to (empty to skip)
+	string plotOutput;						///< Image file for PNG/SVG plots (empty picks kmeans.png / kmeans.svg)
+	string verifyOutput;					///< Golden detailed results to compare against (empty to skip)
+	string verifyPlot;						///< Golden plot data to compare against (empty to skip)
+	int K = 3;                       		///< Number of clusters
+	KMeansOptions options;					///< Engine options (seeding, threads, iteration limit)
+	PlotOptions plotOptions;				///< Gnuplot settings (terminal, size, downsampling)
+	int benchRuns = 0;						///< Timed fits per benchmark configuration (0 runs the normal program)
+	size_t syntheticPoints = 0;				///< Benchmark on this many generated points instead of the input file
+	int stressCases = 0;					///< Random cases per self-check (0 runs the normal program)
+	bool plot = true;						///< Whether to launch Gnuplot
+	bool quiet = false;						///< Whether to skip printing results to the console
+	bool stats = false;						///< Whether to print run statistics (timing, per-thread load)
+	bool help = false;						///< Whether --help was given
+};
+
+/**
+ * @brief Prints the list of command line flags.
+ * @param program The name the program was started with.
+ */
+void printUsage(const string& program) {
+    cout << "Usage: " << program << " [options]\n"
+         << "  -i, --input FILE      input data file, one 'index x y' per line (default 40.txt)\n"
+         << "  -k, --clusters K      number of clusters (default 3)\n"
+         << "  -s, --seeding METHOD  first | random | kmeans++ (default first)\n"
+         << "      --seed N          random seed for random and kmeans++ seeding\n"
+         << "  -t, --threads N       assignment threads, 0 uses every hardware thread (default 1)\n"
+         << "      --max-iter N      iteration limit, 0 runs until convergence (default 0)\n"
+         << "      --reduction MODE  fast | deterministic (default fast)\n"
+         << "      --numa            copy the points to every NUMA node and pin the threads\n"
+         << "  -o, --output FILE     detailed results file, 'none' to skip (default output.txt)\n"
+         << "      --plot-data FILE  'x y cluster' file for Gnuplot, 'none' to skip (default plotFile.txt)\n"
+         << "      --csv FILE        also save 'index,x,y,cluster' rows to FILE\n"
+         << "      --gnuplot PATH    Gnuplot executable (default " << PlotOptions().gnuplotPath << ")\n"
+         << "      --plot-format F   window | png | svg (default window)\n"
+         << "      --plot-out FILE   image file for png/svg plots (default kmeans.png / kmeans.svg)\n"
+         << "      --plot-max N      clusters larger than N points are drawn as density bins (default 20000)\n"
+         << "      --no-plot         do not launch Gnuplot\n"
+         << "  -q, --quiet           do not print the results to the console\n"
+         << "      --stats           print iterations, timing and the per-thread load of the run\n"
+         << "      --verify-output F compare the detailed results with the golden file F\n"
+         << "      --verify-plot F   compare the plot data with the golden file F\n"
+         << "      --bench RUNS      time RUNS fits per configuration (reduction modes, NUMA placement, load balance)\n"
+         << "      --synthetic N     benchmark on N generated points instead of the input file\n"
+         << "      --check-invariants verify the Lloyd invariants after every iteration (slow)\n"
+         << "      --stress N        run N random invariant-checked fits and N fuzzed input files\n"
+         << "  -h, --help            show this help\n";
+}
+
+/**
+ * @brief Converts a flag value to an integer.
+ * @param flag The flag the value belongs to (for the error message).
+ * @param value The text to convert.
+ * @return The parsed integer.
+ * @throws invalid_argument If the value is not a whole number.
+ */
+int parseInteger(const string& flag, const string& value) {
+    size_t used = 0;
+    int number = 0;
+    try {
+        number = stoi(value, &used);
+    }
+    catch (const exception&) {
+        used = 0;
+    }
+    if (used == 0 || used != value.size()) {
+        throw invalid_argument("Expected a number after " + flag + ", got '" + value + "'");
+    }
+    return number;
+}
+
+/**
+ * @brief Parses the command line flags.
+ * @param argc Argument count from main().
+ * @param argv Argument vector from main().
+ * @return The collected settings.
+ * @throws invalid_argument If a flag is unknown or its value is missing or malformed.
+ */
+CommandLine parseCommandLine(int argc, char* argv[]) {
+    CommandLine cmd;
+
+    for (int i = 1; i < argc; ++i) {
+        string flag = argv[i];
+        auto value = [&]() -> string {
+            if (i + 1 >= argc) {
+                throw invalid_argument("Missing value after " + flag);
+            }
+            return argv[++i];
+        };
+
+        if (flag == "-i" || flag == "--input") {
+            cmd.inputFile = value();
+        } else if (flag == "-k" || flag == "--clusters") {
+            cmd.K = parseInteger(flag, value());
+        } else if (flag == "-s" || flag == "--seeding") {
+            cmd.options.seeding = parseSeedingMethod(value());
+        } else if (flag == "--seed") {
+            cmd.options.randomSeed = static_cast<unsigned int>(parseInteger(flag, value()));
+        } else if (flag == "-t" || flag == "--threads") {
+            cmd.options.threads = parseInteger(flag, value());
+        } else if (flag == "--max-iter") {
+            cmd.options.maxIterations = parseInteger(flag, value());
+        } else if (flag == "--reduction") {
+            cmd.options.reduction = parseReductionMode(value());
+        } else if (flag == "--numa") {
+            cmd.options.numaPlacement = true;
+        } else if (flag == "--check-invariants") {
+            cmd.options.checkInvariants = true;
+        } else if (flag == "--stress") {
+            cmd.stressCases = parseInteger(flag, value());
+        } else if (flag == "--verify-output") {
+            cmd.verifyOutput = value();
+        } else if (flag == "--verify-plot") {
+            cmd.verifyPlot = value();
+        } else if (flag == "--bench") {
+            cmd.benchRuns = parseInteger(flag, value());
+        } else if (flag == "--synthetic") {
+            int points = parseInteger(flag, value());
+            if (points <= 0) {
+                throw invalid_argument("--synthetic must be positive");
+            }
+            cmd.syntheticPoints = static_cast<size_t>(points);
+        } else if (flag == "-o" || flag == "--output") {
+            cmd.outputFile = value();
+        } else if (flag == "--plot-data") {
+            cmd.plotFile = value();
+        } else if (flag == "--csv") {
+            cmd.csvFile = value();
+        } else if (flag == "--gnuplot") {
+            cmd.plotOptions.gnuplotPath = value();
+        } else if (flag == "--plot-format") {
+            cmd.plotOptions.terminal = parsePlotTerminal(value());
+        } else if (flag == "--plot-out") {
+            cmd.plotOutput = value();
+        } else if (flag == "--plot-max") {
+            int limit = parseInteger(flag, value());
+            if (limit <= 0) {
+                throw invalid_argument("--plot-max must be positive");
+            }
+            cmd.plotOptions.maxPointsPerCluster = static_cast<size_t>(limit);
+        } else if (flag == "--no-plot") {
+            cmd.plot = false;
+        } else if (flag == "-q" || flag == "--quiet") {
+            cmd.quiet = true;
+        } else if (flag == "--stats") {
+            cmd.stats = true;
+        } else if (flag == "-h" || flag == "--help") {
+            cmd.help = true;
+        } else {
+            throw invalid_argument("Unknown option: " + flag);
+        }
+    }
+
+    return cmd;
+}
+
+/**
+ * @brief Compares produced text with a golden file, ignoring Windows line endings.
+ * @param produced The text produced by this run.
+ * @param goldenFile The checked-in file to compare against.
+ * @return True if the texts are identical, otherwise false (the first difference is printed).
+ * @throws runtime_error If the golden file cannot be opened.
+ */
+bool verifyAgainst(const string& produced, const string& goldenFile) {
+    ifstream golden(goldenFile);
+    if (!golden) {
+        throw runtime_error("File not found: " + goldenFile);
     }
 
-    // Write Gnuplot commands to the script
-    gnuplotScript << "set title 'K-Means Clustering Result'\n";
-    gnuplotScript << "set xlabel 'X Coordinate'\n";
-    gnuplotScript << "set ylabel 'Y Coordinate'\n";
-    gnuplotScript << "set palette defined (0 'red', 1 'green', 2 'blue', 3 'yellow', 4 'purple')\n";
-    gnuplotScript << "plot '" << dataFile 
-                  << "' using 1:2:3 with points palette pointtype 7 pointsize 1 title 'Clusters'\n";
-    gnuplotScript << "pause -1\n"; // Keeps the plot window open
-    gnuplotScript.close();
-
-    // Execute the Gnuplot script
-    system("\"C:\\Program Files\\gnuplot\\bin\\gnuplot.exe\" plot_script.gnu");
+    istringstream actual(produced);
+    string expectedLine, actualLine;
+    for (int line = 1; ; ++line) {
+        bool haveExpected = static_cast<bool>(getline(golden, expectedLine));
+        bool haveActual = static_cast<bool>(getline(actual, actualLine));
+        if (haveExpected && !expectedLine.empty() && expectedLine.back() == '\r') {
+            expectedLine.pop_back();
+        }
+        if (!haveExpected && !haveActual) {
+            cout << "Verified against " << goldenFile << endl;
+            return true;
+        }
+        if (haveExpected != haveActual || expectedLine != actualLine) {
+            cerr << goldenFile << ":" << line << ": expected '" << expectedLine
+                 << "', got '" << actualLine << "'" << endl;
+            return false;
+        }
+    }
 }
 
+/**
+ * @brief Prints the statistics of a run: iterations, inertia, timing and the load of every thread.
+ * @param result The result of the run.
+ */
+void printRunStats(const KMeansResult& result) {
+    const vector<double>& busy = result.getThreadBusySeconds();
+    const vector<size_t>& steals = result.getThreadSteals();
+
+    cout << "Iterations : " << result.getIterations() << (result.hasConverged() ? " (converged)" : "") << "\n"
+         << "Inertia : " << result.getInertia() << "\n"
+         << "Iteration time : " << result.getElapsedSeconds() * 1000.0 << " ms\n";
+    for (size_t t = 0; t < busy.size(); ++t) {
+        cout << "Thread " << t << " : busy " << busy[t] * 1000.0 << " ms, " << steals[t] << " steals\n";
+    }
+    cout << "Load imbalance : " << result.getLoadImbalance() << endl;
+}
 
-int main() {
+int main(int argc, char* argv[]) {
     try {
-        string inputFile = "40.txt";     		///< Name of the input data file
-        string outputFile = "output.txt";		///< Name of the file to save detailed clustering results
-		string plotFile = "plotFile.txt"; 		///< Name of the file to save results for Gnuplot
-        int K = 3;                       		///< Number of clusters
+        CommandLine cmd = parseCommandLine(argc, argv);
+        if (cmd.help) {
+            printUsage(argv[0]);
+            return 0;
+        }
+
+        if (cmd.stressCases > 0) {
+            StressTest stress(cmd.options.randomSeed);
+            bool engineOk = stress.checkEngine(cmd.stressCases, cout);
+            bool loaderOk = stress.fuzzLoader(cmd.stressCases, cout);
+            return engineOk && loaderOk ? 0 : 2;
+        }
+
+        if (cmd.benchRuns > 0) {
+            vector<double> xs, ys;
+            PointSpan points;
+            if (cmd.syntheticPoints > 0) {
+                Benchmark::generateBlobs(cmd.syntheticPoints, cmd.K, cmd.options.randomSeed, xs, ys);
+                points = PointSpan(xs.data(), ys.data(), xs.size());
+            } else {
+                KMeans loader(cmd.inputFile, cmd.K);
+                xs.assign(loader.getPoints().xData(), loader.getPoints().xData() + loader.getPoints().size());
+                ys.assign(loader.getPoints().yData(), loader.getPoints().yData() + loader.getPoints().size());
+                points = PointSpan(xs.data(), ys.data(), xs.size());
+            }
+
+            Benchmark benchmark(points, cmd.K, cmd.benchRuns);
+            benchmark.compareReductions(cmd.options, cout);
+            cout << "\n";
+            benchmark.compareNumaPlacement(cmd.options, cout);
+            cout << "\n";
+            benchmark.reportLoadBalance(cmd.options, cout);
+            return 0;
+        }
 
         // Create a KMeans object and execute the algorithm
-        KMeans kmeans(inputFile, K);
+        KMeans kmeans(cmd.inputFile, cmd.K, cmd.options);
         kmeans.run();
 
+        // Compare with checked-in golden results
+        bool verified = true;
+        if (!cmd.verifyOutput.empty()) {
+            ostringstream produced;
+            kmeans.writeResults(produced);
+            verified = verifyAgainst(produced.str(), cmd.verifyOutput) && verified;
+        }
+        if (!cmd.verifyPlot.empty()) {
+            ostringstream produced;
+            kmeans.writePlotData(produced);
+            verified = verifyAgainst(produced.str(), cmd.verifyPlot) && verified;
+        }
+        if (!verified) {
+            return 2;
+        }
+
         // Print results to the console
-        kmeans.printResults();
-        
+        if (!cmd.quiet) {
+            kmeans.printResults();
+        }
+        if (cmd.stats) {
+            printRunStats(kmeans.getResult());
+        }
+
          // Save results to files
-		kmeans.saveResultsToFile(outputFile);
-		
+        if (cmd.outputFile != "none") {
+            kmeans.saveResultsToFile(cmd.outputFile);
+        }
+        if (!cmd.csvFile.empty()) {
+            kmeans.saveResultsAsCsv(cmd.csvFile);
+        }
+
 		// Save results to file for plotting
-		kmeans.saveResultsForPlotting(plotFile);
-		
-		
-        // Visualize results using Gnuplot
-        plotWithGnuplot(plotFile);
+        if (cmd.plotFile != "none") {
+            kmeans.saveResultsForPlotting(cmd.plotFile);
+        }
 
-        cout << "\nK-Means clustering result successfully displayed!" << endl;
+        // Visualize results using Gnuplot
+        if (cmd.plot) {
+            if (cmd.plotOutput.empty()) {
+                cmd.plotOutput = cmd.plotOptions.terminal == PlotTerminal::SVG ? "kmeans.svg" : "kmeans.png";
+            }
+            GnuplotRenderer renderer(cmd.plotOptions);
+            renderer.render(kmeans.getPoints(), kmeans.getResult(), cmd.plotOutput);
+            renderer.close();
+            cout << "\nK-Means clustering result successfully displayed!" << endl;
+        }
     }
     catch (const exception& e) {
         cerr << "Error: " << e.what() << endl;
+        return 1;
     }
 
     return 0;
 }
-